@@ -0,0 +1,119 @@
+#include "Automation.h"
+#include <math.h>
+
+// steepness of AU_EXPONENTIAL, halfway through the rise it has covered 8%
+#define AU_EXP_STEEPNESS 5.f
+
+void au_init(automation* au, int sample_rate){
+	pitch_map unused;
+
+	// the octave curves use pm_exp2, which needs the shared table
+	pm_init(&unused, AU_MIN_FREQUENCY, 2.f * AU_MIN_FREQUENCY);
+
+	au->rise.serial = 0;
+	au->rise.running = 0;
+	au->position = 0;
+	au->length = 0;
+	au->active = 0;
+	au->sample_rate = sample_rate;
+	au->pitch = 0.f;
+	au->cutoff = 0.f;
+	atomic_init(&au->shown_pitch, 0.f);
+	atomic_init(&au->shown_cutoff, 0.f);
+	atomic_init(&au->shown_serial, 0);
+}
+
+void au_update(automation* au, const riser_automation* rise){
+	if (!rise->running){
+		au->active = 0;
+		au->rise.running = 0;
+		return;
+	}
+	if (au->active && rise->serial == au->rise.serial){
+		return;
+	}
+
+	au->rise = *rise;
+	au->position = 0;
+	// a negative or NaN length would not convert, it jumps to the end
+	au->length = (rise->seconds > 0.f)
+		? (unsigned long)(rise->seconds * au->sample_rate) : 0;
+	au->active = 1;
+
+	// keep the logs out of the per-step work
+	if (au->rise.pitch_start < AU_MIN_FREQUENCY){
+		au->rise.pitch_start = AU_MIN_FREQUENCY;
+	}
+	if (au->rise.cutoff_start < AU_MIN_FREQUENCY){
+		au->rise.cutoff_start = AU_MIN_FREQUENCY;
+	}
+	au->pitch_octaves = log2f(fmaxf(rise->pitch_end, AU_MIN_FREQUENCY)
+							/ au->rise.pitch_start);
+	au->cutoff_octaves = log2f(fmaxf(rise->cutoff_end, AU_MIN_FREQUENCY)
+							/ au->rise.cutoff_start);
+}
+
+float au_shape(int curve, float t){
+	switch (curve){
+	case AU_EXPONENTIAL:
+		return (expf(AU_EXP_STEEPNESS * t) - 1.f) / (expf(AU_EXP_STEEPNESS) - 1.f);
+	case AU_S_CURVE:
+		return t * t * (3.f - 2.f * t);
+	case AU_LINEAR:
+	case AU_LOG_FREQ:
+	default:
+		return t;
+	}
+}
+
+// Moves from start to end by shape, in Hz or in octaves
+static float au_interpolate(int curve, float start, float end, float octaves,
+							float shape){
+	if (curve == AU_LOG_FREQ || curve == AU_S_CURVE){
+		return start * pm_exp2(shape * octaves);
+	}
+	return start + (end - start) * shape;
+}
+
+void au_advance(automation* au, int frames){
+	float t, shape;
+
+	if (!au->active){
+		return;
+	}
+
+	t = (au->length == 0 || au->position >= au->length)
+		? 1.f : (float)au->position / au->length;
+	shape = au_shape(au->rise.curve, t);
+	au->pitch = au_interpolate(au->rise.curve, au->rise.pitch_start,
+							au->rise.pitch_end, au->pitch_octaves, shape);
+	au->cutoff = au_interpolate(au->rise.curve, au->rise.cutoff_start,
+							au->rise.cutoff_end, au->cutoff_octaves, shape);
+	au->position += frames;
+
+	atomic_store_explicit(&au->shown_pitch, au->pitch, memory_order_relaxed);
+	atomic_store_explicit(&au->shown_cutoff, au->cutoff, memory_order_relaxed);
+	atomic_store_explicit(&au->shown_serial, au->rise.serial, memory_order_release);
+}
+
+const char* au_curve_name(int curve){
+	switch (curve){
+	case AU_LINEAR:			return "LINEAR";
+	case AU_EXPONENTIAL:	return "EXPONENTIAL";
+	case AU_LOG_FREQ:		return "LOG FREQUENCY";
+	case AU_S_CURVE:		return "S-CURVE";
+	default:				return "UNKNOWN";
+	}
+}
+
+int au_shown_serial(automation* au){
+	return atomic_load_explicit(&au->shown_serial, memory_order_acquire);
+}
+
+float au_shown_pitch(automation* au){
+	return atomic_load_explicit(&au->shown_pitch, memory_order_relaxed);
+}
+
+float au_shown_cutoff(automation* au){
+	return atomic_load_explicit(&au->shown_cutoff, memory_order_relaxed);
+}
@@ -0,0 +1,81 @@
+// Automation Module
+//
+// Riser automation evaluated on the audio thread. A rise moves the pitch
+// and the cutoff from a start to an end value along a curve, advancing by
+// samples rendered, so it runs at the same speed whatever the GUI frame
+// rate. The renderer asks for new values every AU_STEP samples.
+
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <stdatomic.h>
+#include "PitchMap.h"
+
+// samples between two evaluations of the curves
+#define AU_STEP 16
+
+// lowest frequency a rise starts from, keeps the octave curves finite
+#define AU_MIN_FREQUENCY 20.f
+
+typedef enum {
+	AU_LINEAR		= 0,	// straight line in Hz
+	AU_EXPONENTIAL	= 1,	// slow start, fast finish, in Hz
+	AU_LOG_FREQ		= 2,	// straight line in octaves
+	AU_S_CURVE		= 3,	// smoothstep in octaves
+} AU_CURVES;
+
+#define AU_CURVE_COUNT 4
+
+// A rise as requested by the GUI, travels inside riser_params
+typedef struct _riser_automation{
+	int serial;				// a new value (re)starts the rise
+	int running;			// 0 stops it, the parameters take over again
+	int curve;
+	float seconds;
+	float pitch_start;
+	float pitch_end;
+	float cutoff_start;
+	float cutoff_end;
+}riser_automation;
+
+typedef struct _automation{
+	riser_automation rise;
+	unsigned long position;	// samples since the rise started
+	unsigned long length;	// samples the rise takes, it holds the end after
+	int active;
+	int sample_rate;
+	// octaves covered, for the curves that move in octaves
+	float pitch_octaves;
+	float cutoff_octaves;
+	float pitch;			// values for the samples being rendered
+	float cutoff;
+	// last values, readable from other threads
+	_Atomic float shown_pitch;
+	_Atomic float shown_cutoff;
+	atomic_int shown_serial;	// rise the shown values belong to
+}automation;
+
+// Also builds the exp2 table of PitchMap the first time it is called, so
+// call it before the audio thread starts.
+void au_init(automation* au, int sample_rate);
+
+// Starts the rise when its serial changed, stops it when it is no longer
+// running. Call once per block before au_advance.
+void au_update(automation* au, const riser_automation* rise);
+
+// Sets pitch and cutoff for the next frames (at most AU_STEP) samples
+void au_advance(automation* au, int frames);
+
+// Shape of curve at progress t in [0, 1], from 0 to 1
+float au_shape(int curve, float t);
+
+const char* au_curve_name(int curve);
+
+// Pitch and cutoff last rendered, for the GUI
+float au_shown_pitch(automation* au);
+float au_shown_cutoff(automation* au);
+
+// Serial of the rise the shown values come from, 0 before the first one
+int au_shown_serial(automation* au);
+
+#endif
@@ -3,23 +3,129 @@
 #include <stdlib.h>
 #include <math.h>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 #ifndef M_PI
 #define M_PI (3.141592654)
 #endif
 
-biquad* bq_new(int filter_type,
+// positions in biquad.dc and biquad.svf
+enum { DC_B0, DC_B1, DC_B2, DC_A1, DC_A2 };
+enum { SVF_G, SVF_K, SVF_M0, SVF_M1, SVF_M2 };
+
+// Gains of the SVF update, from its g and k
+static void bq_svf_gains(biquad* bq){
+	float g = bq->svf[SVF_G];
+	bq->svf_a1 = 1.f / (1.f + g * (g + bq->svf[SVF_K]));
+	bq->svf_a2 = g * bq->svf_a1;
+	bq->svf_a3 = g * bq->svf_a2;
+}
+
+void bq_design(int filter_type,
+				double frequency,
+				double q,
+				double dbGain,
+				int sample_rate,
+				double* coefficients){
+
+	double A = pow(10, dbGain / 40.);
+	double omega = 2 * M_PI * frequency / sample_rate;
+	double sn = sin(omega);
+	double cs = cos(omega);
+	double alpha = sn / (2 * q);
+	double beta = sqrt(A + A);
+	double b0, b1, b2, a0, a1, a2;
+
+	switch (filter_type){
+		case HIGHPASS:
+			b0 = (1 + cs) / 2;	b1 = -(1 + cs);		b2 = (1 + cs) / 2;
+			a0 = 1 + alpha;		a1 = -2 * cs;		a2 = 1 - alpha;
+			break;
+		case BANDPASS:
+			b0 = alpha;			b1 = 0;				b2 = -alpha;
+			a0 = 1 + alpha;		a1 = -2 * cs;		a2 = 1 - alpha;
+			break;
+		case NOTCH:
+			b0 = 1;				b1 = -2 * cs;		b2 = 1;
+			a0 = 1 + alpha;		a1 = -2 * cs;		a2 = 1 - alpha;
+			break;
+		case PEAK:
+			b0 = 1 + alpha * A;	b1 = -2 * cs;		b2 = 1 - alpha * A;
+			a0 = 1 + alpha / A;	a1 = -2 * cs;		a2 = 1 - alpha / A;
+			break;
+		case LOWSHELF:
+			b0 = A * ((A + 1) - (A - 1) * cs + beta * sn);
+			b1 = 2 * A * ((A - 1) - (A + 1) * cs);
+			b2 = A * ((A + 1) - (A - 1) * cs - beta * sn);
+			a0 = (A + 1) + (A - 1) * cs + beta * sn;
+			a1 = -2 * ((A - 1) + (A + 1) * cs);
+			a2 = (A + 1) + (A - 1) * cs - beta * sn;
+			break;
+		case HIGHSHELF:
+			b0 = A * ((A + 1) + (A - 1) * cs + beta * sn);
+			b1 = -2 * A * ((A - 1) + (A + 1) * cs);
+			b2 = A * ((A + 1) + (A - 1) * cs - beta * sn);
+			a0 = (A + 1) - (A - 1) * cs + beta * sn;
+			a1 = 2 * ((A - 1) - (A + 1) * cs);
+			a2 = (A + 1) - (A - 1) * cs - beta * sn;
+			break;
+		default:	// LOWPASS
+			b0 = (1 - cs) / 2;	b1 = 1 - cs;		b2 = (1 - cs) / 2;
+			a0 = 1 + alpha;		a1 = -2 * cs;		a2 = 1 - alpha;
+			break;
+	}
+
+	coefficients[0] = b0;
+	coefficients[1] = b1;
+	coefficients[2] = b2;
+	coefficients[3] = a0;
+	coefficients[4] = a1;
+	coefficients[5] = a2;
+}
+
+// The design of bq in double, normalized to a0, into bq->dc. Trig in
+// float leaves 1 - cos(omega) with a handful of bits at low cutoffs.
+static void bq_calculate_double(biquad* bq){
+	double design[6];
+	bq_design(bq->filter_type, bq->frequency, bq->q, bq->db_gain,
+				bq->sample_rate, design);
+	bq->dc[DC_B0] = design[0] / design[3];
+	bq->dc[DC_B1] = design[1] / design[3];
+	bq->dc[DC_B2] = design[2] / design[3];
+	bq->dc[DC_A1] = design[4] / design[3];
+	bq->dc[DC_A2] = design[5] / design[3];
+}
+
+// SVF with the transfer function of bq->dc. The bilinear biquad and the
+// trapezoidal SVF share the denominator D + 2(g^2 - 1)z^-1 + (1 - gk + g^2)z^-2
+// with D = 1 + gk + g^2, which gives g and k; matching the numerator
+// against m0 D(z) + m1 g(1 - z^-2) + m2 g^2(1 + z^-1)^2 gives the mix.
+static void bq_calculate_svf(biquad* bq){
+	double b0 = bq->dc[DC_B0], b1 = bq->dc[DC_B1], b2 = bq->dc[DC_B2];
+	double a1 = bq->dc[DC_A1], a2 = bq->dc[DC_A2];
+	double d = 4 / (1 - a1 + a2);
+	double g = sqrt((1 + a1 + a2) / (1 - a1 + a2));
+	double k = (d - 1 - g * g) / g;
+	double m0 = (b0 - b1 + b2) * d / 4;
+
+	bq->svf[SVF_G] = g;
+	bq->svf[SVF_K] = k;
+	bq->svf[SVF_M0] = m0;
+	bq->svf[SVF_M1] = ((b0 - b2) * d - 2 * g * k * m0) / (2 * g);
+	bq->svf[SVF_M2] = (b1 * d - 2 * m0 * (g * g - 1)) / (2 * g * g);
+	bq_svf_gains(bq);
+}
+
+// Fills the coefficient fields of bq, normalized to a0, and those of its
+// topology
+static void bq_calculate(biquad* bq, int filter_type,
 				float frequency,
 				float Q,
 				float dbGain,
 				int sample_rate){
 
-	biquad* tmp = (biquad*)malloc(sizeof(biquad));
-	
-	if (tmp == NULL){
-		printf("Error while allocating memory for biquad");
-		return tmp;
-	}
-
 // Calculate helper variables for
 // generating 'a' and 'b' coefficients
 //////////////////////////////////////
@@ -30,36 +136,327 @@ biquad* bq_new(int filter_type,
     float alpha = sn / (2*Q);
     float beta = sqrt(A + A);
 // Load 'a' and 'b' coefficients
-// into tmp biquad
+// into bq
 /////////////////////////////////
-	bq_load_coefficients(tmp, filter_type,
+	bq_load_coefficients(bq, filter_type,
 						A, omega,
 						sn, cs,
 						alpha, beta);
 //Scale coeffs to a0
 ////////////////////
-	// tmp->a1 = (tmp->a1) / (tmp->a0);
-	// tmp->a2 = (tmp->a2) / (tmp->a0);
-	// tmp->b0 = (tmp->b0) / (tmp->a0);
-	// tmp->b1 = (tmp->b1) / (tmp->a0);
-	// tmp->b2 = (tmp->b2) / (tmp->a0);
-	tmp->a1 /= (tmp->a0);
-	tmp->a2 /= (tmp->a0);
-	tmp->b0 /= (tmp->a0);
-	tmp->b1 /= (tmp->a0);
-	tmp->b2 /= (tmp->a0);
+	bq->a1 /= (bq->a0);
+	bq->a2 /= (bq->a0);
+	bq->b0 /= (bq->a0);
+	bq->b1 /= (bq->a0);
+	bq->b2 /= (bq->a0);
+
+	bq->filter_type = filter_type;
+	bq->frequency = frequency;
+	bq->q = Q;
+	bq->db_gain = dbGain;
+	bq->sample_rate = sample_rate;
+	if (bq->topology == BQ_TDF2_DOUBLE || bq->topology == BQ_SVF){
+		bq_calculate_double(bq);
+	}
+	if (bq->topology == BQ_SVF){
+		bq_calculate_svf(bq);
+	}
+}
+
+// Clears the history of every topology and stops any glide
+static void bq_clear(biquad* bq){
+	bq->prev_input_1 = 0.0;
+	bq->prev_input_2 = 0.0;
+	bq->prev_output_1 = 0.0;
+	bq->prev_output_2 = 0.0;
+	bq->s1 = 0.f;
+	bq->s2 = 0.f;
+	bq->ds1 = 0.0;
+	bq->ds2 = 0.0;
+	bq->ramp_remaining = 0;
+}
+
+biquad* bq_new(int filter_type,
+				float frequency,
+				float Q,
+				float dbGain,
+				int sample_rate){
+
+	biquad* tmp = (biquad*)malloc(sizeof(biquad));
+	
+	if (tmp == NULL){
+		printf("Error while allocating memory for biquad");
+		return tmp;
+	}
+
+	bq_init(tmp, filter_type, frequency, Q, dbGain, sample_rate);
+
+	return tmp;
+}
+
+void bq_init(biquad* bq, int filter_type,
+				float frequency,
+				float Q,
+				float dbGain,
+				int sample_rate){
+
+	bq->topology = BQ_DF1;
+	bq_calculate(bq, filter_type, frequency, Q, dbGain, sample_rate);
 
 // Load rest of data
 /////////////////////////////////
-	tmp->prev_input_1 = 0.0;
-	tmp->prev_input_2 = 0.0;
-	tmp->prev_output_1 = 0.0;
-	tmp->prev_output_2 = 0.0;
+	bq_clear(bq);
+}
 
-	return tmp;
+void bq_set_target(biquad* bq, int filter_type,
+				float frequency,
+				float Q,
+				float dbGain,
+				int sample_rate,
+				int ramp_length){
+
+	biquad next;
+	next.topology = bq->topology;
+	bq_calculate(&next, filter_type, frequency, Q, dbGain, sample_rate);
+	bq_glide_to(bq, &next, ramp_length);
+}
+
+void bq_glide_to(biquad* bq, const biquad* target, int ramp_length){
+	int i;
+
+	if (target->topology != bq->topology){
+		bq_set_target(bq, target->filter_type, target->frequency, target->q,
+					target->db_gain, target->sample_rate, ramp_length);
+		return;
+	}
+
+	bq->a0 = target->a0;
+	bq->type = target->type;
+	bq->filter_type = target->filter_type;
+	bq->frequency = target->frequency;
+	bq->q = target->q;
+	bq->db_gain = target->db_gain;
+	bq->sample_rate = target->sample_rate;
+
+	if (ramp_length <= 0){
+		bq->a1 = target->a1;
+		bq->a2 = target->a2;
+		bq->b0 = target->b0;
+		bq->b1 = target->b1;
+		bq->b2 = target->b2;
+		for (i = 0; i < 5; i++){
+			if (bq->topology == BQ_TDF2_DOUBLE){
+				bq->dc[i] = target->dc[i];
+			}
+			if (bq->topology == BQ_SVF){
+				bq->svf[i] = target->svf[i];
+			}
+		}
+		if (bq->topology == BQ_SVF){
+			bq_svf_gains(bq);
+		}
+		bq->ramp_remaining = 0;
+		return;
+	}
+
+	for (i = 0; i < 5; i++){
+		if (bq->topology == BQ_TDF2_DOUBLE){
+			bq->dc_target[i] = target->dc[i];
+			bq->dc_step[i] = (target->dc[i] - bq->dc[i]) / ramp_length;
+		}
+		if (bq->topology == BQ_SVF){
+			bq->svf_target[i] = target->svf[i];
+			bq->svf_step[i] = (target->svf[i] - bq->svf[i]) / ramp_length;
+		}
+	}
+
+	bq->target_a1 = target->a1;
+	bq->target_a2 = target->a2;
+	bq->target_b0 = target->b0;
+	bq->target_b1 = target->b1;
+	bq->target_b2 = target->b2;
+	bq->step_a1 = (target->a1 - bq->a1) / ramp_length;
+	bq->step_a2 = (target->a2 - bq->a2) / ramp_length;
+	bq->step_b0 = (target->b0 - bq->b0) / ramp_length;
+	bq->step_b1 = (target->b1 - bq->b1) / ramp_length;
+	bq->step_b2 = (target->b2 - bq->b2) / ramp_length;
+	bq->ramp_remaining = ramp_length;
+}
+
+void bq_set_topology(biquad* bq, int topology){
+	bq->topology = topology;
+	bq_calculate(bq, bq->filter_type, bq->frequency, bq->q, bq->db_gain,
+				bq->sample_rate);
+	bq_clear(bq);
+}
+
+const char* bq_topology_name(int topology){
+	switch (topology){
+	case BQ_DF1:			return "DIRECT FORM I";
+	case BQ_TDF2:			return "TRANSPOSED DF II";
+	case BQ_TDF2_DOUBLE:	return "TRANSPOSED DF II DOUBLE";
+	case BQ_SVF:			return "STATE VARIABLE";
+	default:				return "UNKNOWN";
+	}
+}
+
+int bq_flush_denormals(int flush){
+#if defined(__SSE__)
+	// FTZ is bit 15 and DAZ bit 6 of MXCSR
+	unsigned int csr = _mm_getcsr();
+	unsigned int mode = flush ? (csr | 0x8040) : (csr & ~0x8040);
+	if (mode != csr){
+		_mm_setcsr(mode);
+	}
+	return (csr & 0x8040) == 0x8040;
+#elif defined(__aarch64__)
+	// FZ is bit 24 of FPCR, it covers both
+	unsigned long long fpcr, mode;
+	__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+	mode = flush ? (fpcr | (1ULL << 24)) : (fpcr & ~(1ULL << 24));
+	if (mode != fpcr){
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+	}
+	return (fpcr & (1ULL << 24)) != 0;
+#else
+	(void)flush;
+	return 0;
+#endif
+}
+
+// One step of the glide for the topologies other than BQ_DF1, only the
+// coefficients the topology runs on move
+static void bq_ramp_step(biquad* bq){
+	int i;
+
+	if (--bq->ramp_remaining == 0){
+		bq->a1 = bq->target_a1;
+		bq->a2 = bq->target_a2;
+		bq->b0 = bq->target_b0;
+		bq->b1 = bq->target_b1;
+		bq->b2 = bq->target_b2;
+		for (i = 0; i < 5; i++){
+			if (bq->topology == BQ_TDF2_DOUBLE){
+				bq->dc[i] = bq->dc_target[i];
+			}
+			if (bq->topology == BQ_SVF){
+				bq->svf[i] = bq->svf_target[i];
+			}
+		}
+	}
+	else if (bq->topology == BQ_TDF2){
+		bq->a1 += bq->step_a1;
+		bq->a2 += bq->step_a2;
+		bq->b0 += bq->step_b0;
+		bq->b1 += bq->step_b1;
+		bq->b2 += bq->step_b2;
+	}
+	else if (bq->topology == BQ_TDF2_DOUBLE){
+		for (i = 0; i < 5; i++){
+			bq->dc[i] += bq->dc_step[i];
+		}
+	}
+	else{
+		for (i = 0; i < 5; i++){
+			bq->svf[i] += bq->svf_step[i];
+		}
+	}
+
+	if (bq->topology == BQ_SVF){
+		bq_svf_gains(bq);
+	}
+}
+
+// bq_process for the topologies other than BQ_DF1
+static float bq_process_topology(biquad* bq, float input){
+	float output;
+
+	if (bq->topology == BQ_TDF2){
+		output = bq->b0 * input + bq->s1;
+		bq->s1 = bq->b1 * input - bq->a1 * output + bq->s2;
+		bq->s2 = bq->b2 * input - bq->a2 * output;
+	}
+	else if (bq->topology == BQ_TDF2_DOUBLE){
+		double y = bq->dc[DC_B0] * input + bq->ds1;
+		bq->ds1 = bq->dc[DC_B1] * input - bq->dc[DC_A1] * y + bq->ds2;
+		bq->ds2 = bq->dc[DC_B2] * input - bq->dc[DC_A2] * y;
+		output = (float)y;
+	}
+	else{
+		float v3 = input - bq->s2;
+		float v1 = bq->svf_a1 * bq->s1 + bq->svf_a2 * v3;
+		float v2 = bq->s2 + bq->svf_a2 * bq->s1 + bq->svf_a3 * v3;
+		bq->s1 = 2.f * v1 - bq->s1;
+		bq->s2 = 2.f * v2 - bq->s2;
+		output = bq->svf[SVF_M0] * input + bq->svf[SVF_M1] * v1 + bq->svf[SVF_M2] * v2;
+	}
+
+	if (bq->ramp_remaining > 0){
+		bq_ramp_step(bq);
+	}
+	return output;
+}
+
+// bq_process_block for the topologies other than BQ_DF1
+static void bq_process_block_topology(biquad* bq, const float* in, float* out, size_t n){
+	size_t i = 0;
+
+	while (i < n && bq->ramp_remaining > 0){
+		out[i] = bq_process_topology(bq, in[i]);
+		i++;
+	}
+
+	if (bq->topology == BQ_TDF2){
+		float b0 = bq->b0, b1 = bq->b1, b2 = bq->b2;
+		float a1 = bq->a1, a2 = bq->a2;
+		float s1 = bq->s1, s2 = bq->s2;
+		for (; i < n; i++){
+			float x = in[i];
+			float y = b0 * x + s1;
+			s1 = b1 * x - a1 * y + s2;
+			s2 = b2 * x - a2 * y;
+			out[i] = y;
+		}
+		bq->s1 = s1;
+		bq->s2 = s2;
+	}
+	else if (bq->topology == BQ_TDF2_DOUBLE){
+		double b0 = bq->dc[DC_B0], b1 = bq->dc[DC_B1], b2 = bq->dc[DC_B2];
+		double a1 = bq->dc[DC_A1], a2 = bq->dc[DC_A2];
+		double s1 = bq->ds1, s2 = bq->ds2;
+		for (; i < n; i++){
+			double x = in[i];
+			double y = b0 * x + s1;
+			s1 = b1 * x - a1 * y + s2;
+			s2 = b2 * x - a2 * y;
+			out[i] = (float)y;
+		}
+		bq->ds1 = s1;
+		bq->ds2 = s2;
+	}
+	else{
+		float a1 = bq->svf_a1, a2 = bq->svf_a2, a3 = bq->svf_a3;
+		float m0 = bq->svf[SVF_M0], m1 = bq->svf[SVF_M1], m2 = bq->svf[SVF_M2];
+		float s1 = bq->s1, s2 = bq->s2;
+		for (; i < n; i++){
+			float x = in[i];
+			float v3 = x - s2;
+			float v1 = a1 * s1 + a2 * v3;
+			float v2 = s2 + a2 * s1 + a3 * v3;
+			s1 = 2.f * v1 - s1;
+			s2 = 2.f * v2 - s2;
+			out[i] = m0 * x + m1 * v1 + m2 * v2;
+		}
+		bq->s1 = s1;
+		bq->s2 = s2;
+	}
 }
 
 float bq_process(biquad* bq, float input){
+	if (bq->topology != BQ_DF1){
+		return bq_process_topology(bq, input);
+	}
+
 	float output = 	(bq->b0 * input) +
 					(bq->b1 * bq->prev_input_1) +
 					(bq->b2* bq->prev_input_2) -
@@ -70,9 +467,250 @@ float bq_process(biquad* bq, float input){
 	bq->prev_output_2 = bq->prev_output_1;
 	bq->prev_output_1 = output;
 	//update last samples...
+
+	//glide towards the coefficients requested by bq_set_target
+	if (bq->ramp_remaining > 0){
+		if (--bq->ramp_remaining == 0){
+			bq->a1 = bq->target_a1;
+			bq->a2 = bq->target_a2;
+			bq->b0 = bq->target_b0;
+			bq->b1 = bq->target_b1;
+			bq->b2 = bq->target_b2;
+		}
+		else{
+			bq->a1 += bq->step_a1;
+			bq->a2 += bq->step_a2;
+			bq->b0 += bq->step_b0;
+			bq->b1 += bq->step_b1;
+			bq->b2 += bq->step_b2;
+		}
+	}
 	return output;
 }
 
+// Samples left until every filter in bqs has finished its ramp
+static size_t bq_ramp_length(biquad** bqs, int count){
+	size_t longest = 0;
+	int c;
+	for (c = 0; c < count; c++){
+		if ((size_t)bqs[c]->ramp_remaining > longest){
+			longest = bqs[c]->ramp_remaining;
+		}
+	}
+	return longest;
+}
+
+void bq_process_block(biquad* bq, const float* in, float* out, size_t n){
+	size_t i = 0;
+
+	if (bq->topology != BQ_DF1){
+		bq_process_block_topology(bq, in, out, n);
+		return;
+	}
+
+// While the coefficients glide, go through bq_process
+//////////////////////////////////////////////////////
+	while (i < n && bq->ramp_remaining > 0){
+		out[i] = bq_process(bq, in[i]);
+		i++;
+	}
+
+// Fixed coefficients, keep everything in registers
+///////////////////////////////////////////////////
+	float b0 = bq->b0, b1 = bq->b1, b2 = bq->b2;
+	float a1 = bq->a1, a2 = bq->a2;
+	float x1 = bq->prev_input_1, x2 = bq->prev_input_2;
+	float y1 = bq->prev_output_1, y2 = bq->prev_output_2;
+
+	for (; i < n; i++){
+		float x = in[i];
+		float y = (b0 * x) + (b1 * x1) + (b2 * x2) - (a1 * y1) - (a2 * y2);
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = y;
+		out[i] = y;
+	}
+
+	bq->prev_input_1 = x1;
+	bq->prev_input_2 = x2;
+	bq->prev_output_1 = y1;
+	bq->prev_output_2 = y2;
+}
+
+#ifdef __SSE__
+// Filters up to four interleaved channels starting at channel first,
+// one channel per SSE lane. Coefficients must not be ramping.
+static void bq_process_lanes(biquad** bqs, int first, int lanes, int channels,
+						const float* in, float* out, size_t frames){
+	float load[4] = {0, 0, 0, 0};
+	float store[4];
+	// per lane b0, b1, b2, a1, a2, x1, x2, y1, y2
+	float lane[9][4] = {{0}};
+	size_t f;
+	int l;
+
+	for (l = 0; l < lanes; l++){
+		biquad* bq = bqs[first + l];
+		lane[0][l] = bq->b0;
+		lane[1][l] = bq->b1;
+		lane[2][l] = bq->b2;
+		lane[3][l] = bq->a1;
+		lane[4][l] = bq->a2;
+		lane[5][l] = bq->prev_input_1;
+		lane[6][l] = bq->prev_input_2;
+		lane[7][l] = bq->prev_output_1;
+		lane[8][l] = bq->prev_output_2;
+	}
+
+	__m128 b0 = _mm_loadu_ps(lane[0]), b1 = _mm_loadu_ps(lane[1]);
+	__m128 b2 = _mm_loadu_ps(lane[2]);
+	__m128 a1 = _mm_loadu_ps(lane[3]), a2 = _mm_loadu_ps(lane[4]);
+	__m128 x1 = _mm_loadu_ps(lane[5]), x2 = _mm_loadu_ps(lane[6]);
+	__m128 y1 = _mm_loadu_ps(lane[7]), y2 = _mm_loadu_ps(lane[8]);
+
+	for (f = 0; f < frames; f++){
+		const float* frame_in = in + f * channels + first;
+		float* frame_out = out + f * channels + first;
+		__m128 x, y;
+
+		if (lanes == 4){
+			x = _mm_loadu_ps(frame_in);
+		}
+		else{
+			for (l = 0; l < lanes; l++){
+				load[l] = frame_in[l];
+			}
+			x = _mm_loadu_ps(load);
+		}
+
+		// same operation order as bq_process
+		y = _mm_mul_ps(b0, x);
+		y = _mm_add_ps(y, _mm_mul_ps(b1, x1));
+		y = _mm_add_ps(y, _mm_mul_ps(b2, x2));
+		y = _mm_sub_ps(y, _mm_mul_ps(a1, y1));
+		y = _mm_sub_ps(y, _mm_mul_ps(a2, y2));
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = y;
+
+		if (lanes == 4){
+			_mm_storeu_ps(frame_out, y);
+		}
+		else{
+			_mm_storeu_ps(store, y);
+			for (l = 0; l < lanes; l++){
+				frame_out[l] = store[l];
+			}
+		}
+	}
+
+	_mm_storeu_ps(lane[5], x1);
+	_mm_storeu_ps(lane[6], x2);
+	_mm_storeu_ps(lane[7], y1);
+	_mm_storeu_ps(lane[8], y2);
+	for (l = 0; l < lanes; l++){
+		biquad* bq = bqs[first + l];
+		bq->prev_input_1 = lane[5][l];
+		bq->prev_input_2 = lane[6][l];
+		bq->prev_output_1 = lane[7][l];
+		bq->prev_output_2 = lane[8][l];
+	}
+}
+#endif
+
+void bq_process_interleaved(biquad** bqs, int channels,
+						const float* in, float* out, size_t frames){
+	size_t f = 0;
+	size_t ramp = bq_ramp_length(bqs, channels);
+	int c;
+
+// The lanes only run direct form I
+///////////////////////////////////
+	for (c = 0; c < channels; c++){
+		if (bqs[c]->topology != BQ_DF1){
+			ramp = frames;
+		}
+	}
+
+// Ramping coefficients go through bq_process
+/////////////////////////////////////////////
+	for (; f < frames && f < ramp; f++){
+		for (c = 0; c < channels; c++){
+			out[f * channels + c] = bq_process(bqs[c], in[f * channels + c]);
+		}
+	}
+	if (f == frames){
+		return;
+	}
+
+#ifdef __SSE__
+	for (c = 0; c < channels; c += 4){
+		int lanes = (channels - c < 4) ? channels - c : 4;
+		bq_process_lanes(bqs, c, lanes, channels,
+						in + f * channels, out + f * channels, frames - f);
+	}
+#else
+	for (; f < frames; f++){
+		for (c = 0; c < channels; c++){
+			out[f * channels + c] = bq_process(bqs[c], in[f * channels + c]);
+		}
+	}
+#endif
+}
+
+void bq_process_cascade(biquad* first, biquad* second,
+						const float* in, float* out, size_t n){
+	biquad* both[2] = {first, second};
+	size_t ramp = bq_ramp_length(both, 2);
+	size_t i = 0;
+
+	// one pass through each, in may be out
+	if (first->topology != BQ_DF1 || second->topology != BQ_DF1){
+		bq_process_block(first, in, out, n);
+		bq_process_block(second, out, out, n);
+		return;
+	}
+
+	for (; i < n && i < ramp; i++){
+		out[i] = bq_process(second, bq_process(first, in[i]));
+	}
+
+	float fb0 = first->b0, fb1 = first->b1, fb2 = first->b2;
+	float fa1 = first->a1, fa2 = first->a2;
+	float fx1 = first->prev_input_1, fx2 = first->prev_input_2;
+	float fy1 = first->prev_output_1, fy2 = first->prev_output_2;
+	float sb0 = second->b0, sb1 = second->b1, sb2 = second->b2;
+	float sa1 = second->a1, sa2 = second->a2;
+	float sx1 = second->prev_input_1, sx2 = second->prev_input_2;
+	float sy1 = second->prev_output_1, sy2 = second->prev_output_2;
+
+	for (; i < n; i++){
+		float x = in[i];
+		float m = (fb0 * x) + (fb1 * fx1) + (fb2 * fx2) - (fa1 * fy1) - (fa2 * fy2);
+		float y = (sb0 * m) + (sb1 * sx1) + (sb2 * sx2) - (sa1 * sy1) - (sa2 * sy2);
+		fx2 = fx1;
+		fx1 = x;
+		fy2 = fy1;
+		fy1 = m;
+		sx2 = sx1;
+		sx1 = m;
+		sy2 = sy1;
+		sy1 = y;
+		out[i] = y;
+	}
+
+	first->prev_input_1 = fx1;
+	first->prev_input_2 = fx2;
+	first->prev_output_1 = fy1;
+	first->prev_output_2 = fy2;
+	second->prev_input_1 = sx1;
+	second->prev_input_2 = sx2;
+	second->prev_output_1 = sy1;
+	second->prev_output_2 = sy2;
+}
+
 void bq_destroy(biquad* bq){
 	free(bq);
 }
@@ -1,4 +1,16 @@
 // Bi-Quad Module
+//
+// RBJ cookbook filters. Every filter runs in one of BQ_TOPOLOGY_COUNT
+// structures, picked per filter with bq_set_topology. Direct form I in
+// float is the default and the fastest. At low cutoffs and high Q its
+// poles sit a few float steps inside the unit circle, so it rings and
+// its tail decays into denormals. The transposed direct form II in
+// double and the state variable filter keep their precision there.
+
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include <stddef.h>
 
 typedef struct _biquad{
 	float a0;
@@ -12,6 +24,43 @@ typedef struct _biquad{
 	float prev_output_1;
 	float prev_output_2;
 	char* type;
+	// coefficient ramp used by bq_set_target
+	float target_a1;
+	float target_a2;
+	float target_b0;
+	float target_b1;
+	float target_b2;
+	float step_a1;
+	float step_a2;
+	float step_b0;
+	float step_b1;
+	float step_b2;
+	int ramp_remaining;
+
+	// structure the filter runs in, BQ_DF1 after bq_init
+	int topology;
+	// design of the coefficients, bq_set_topology recalculates from it
+	int filter_type;
+	float frequency;
+	float q;
+	float db_gain;
+	int sample_rate;
+	// BQ_TDF2 state, or the two integrator states of BQ_SVF
+	float s1;
+	float s2;
+	// BQ_TDF2_DOUBLE: b0, b1, b2, a1, a2 with their ramp, and the state
+	double dc[5];
+	double dc_target[5];
+	double dc_step[5];
+	double ds1;
+	double ds2;
+	// BQ_SVF: g, k, m0, m1, m2 with their ramp, and the gains taken from g, k
+	float svf[5];
+	float svf_target[5];
+	float svf_step[5];
+	float svf_a1;
+	float svf_a2;
+	float svf_a3;
 }biquad;
 
 typedef enum {
@@ -24,14 +73,83 @@ typedef enum {
 	HIGHSHELF	= 6,
 } FILTER_TYPES;
 
+typedef enum {
+	BQ_DF1			= 0,	// direct form I in float
+	BQ_TDF2			= 1,	// transposed direct form II in float
+	BQ_TDF2_DOUBLE	= 2,	// transposed direct form II, double coefficients and state
+	BQ_SVF			= 3,	// trapezoidal state variable filter (Cytomic)
+} BQ_TOPOLOGIES;
+
+#define BQ_TOPOLOGY_COUNT 4
+
 biquad* bq_new(int filter_type,
 				float frequency,
 				float q,
 				float dbGain,
 				int sample_rate);
 
+// Same as bq_new but for a biquad the caller already owns.
+// Resets the filter history and the topology to BQ_DF1.
+void bq_init(biquad* bq, int filter_type,
+				float frequency,
+				float q,
+				float dbGain,
+				int sample_rate);
+
+// Retunes the filter without touching its history. The coefficients
+// glide linearly to the new values over ramp_length samples
+// (0 = jump immediately).
+void bq_set_target(biquad* bq, int filter_type,
+				float frequency,
+				float q,
+				float dbGain,
+				int sample_rate,
+				int ramp_length);
+
+// Glides bq towards the coefficients of target, which can be shared by
+// many filters so the trig only runs once. History is kept. A target in
+// another topology is recalculated for bq's.
+void bq_glide_to(biquad* bq, const biquad* target, int ramp_length);
+
+// The exact coefficients of a design in double, before normalizing to
+// a0, into coefficients[6] as b0, b1, b2, a0, a1, a2. Nothing is
+// filtered with them, CoefTable builds its tables from them.
+void bq_design(int filter_type,
+				double frequency,
+				double q,
+				double dbGain,
+				int sample_rate,
+				double* coefficients);
+
+// Recalculates the coefficients of the last design for topology and
+// clears the history. A running glide jumps to its end.
+void bq_set_topology(biquad* bq, int topology);
+
+const char* bq_topology_name(int topology);
+
+// Flushes denormal results and operands to zero on the calling thread
+// (FTZ and DAZ with SSE, FZ on ARM), 0 turns it off again. Decaying
+// filter tails otherwise slow the FPU down several times over.
+// Only writes the control register when the mode changes. Returns the
+// previous mode so library code can put the caller's mode back.
+int bq_flush_denormals(int flush);
+
 float bq_process(biquad* bq, float input);
 
+// Block versions of bq_process. They give the same output as calling
+// bq_process sample by sample, in and out may be the same buffer.
+
+void bq_process_block(biquad* bq, const float* in, float* out, size_t n);
+
+// Filters frames of interleaved audio, channel c through bqs[c].
+// Uses SSE to run four channels per instruction where available.
+void bq_process_interleaved(biquad** bqs, int channels,
+						const float* in, float* out, size_t frames);
+
+// Runs in through first and then through second in a single pass
+void bq_process_cascade(biquad* first, biquad* second,
+						const float* in, float* out, size_t n);
+
 void bq_destroy(biquad* bq);
 
 void bq_print_info(biquad* bq);
@@ -39,4 +157,6 @@ void bq_print_info(biquad* bq);
 void bq_load_coefficients(biquad* bq, int filter_type,
 						float A, float omega,
 						float sn, float cs,
-						float alpha, float beta);
\ No newline at end of file
+						float alpha, float beta);
+
+#endif
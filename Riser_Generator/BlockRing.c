@@ -0,0 +1,95 @@
+#include "BlockRing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+block_ring* br_new(int slot_count, int block_size){
+	int i;
+	block_ring* tmp = (block_ring*)malloc(sizeof(block_ring));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for block ring");
+		return tmp;
+	}
+
+	tmp->blocks = (float*)calloc(slot_count * block_size, sizeof(float));
+	tmp->sequence = (atomic_uint*)malloc(slot_count * sizeof(atomic_uint));
+	if (tmp->blocks == NULL || tmp->sequence == NULL){
+		printf("Error while allocating memory for block ring");
+		free(tmp->blocks);
+		free(tmp->sequence);
+		free(tmp);
+		return NULL;
+	}
+
+	for (i = 0; i < slot_count; i++){
+		atomic_init(&tmp->sequence[i], 0);
+	}
+	tmp->slot_count = slot_count;
+	tmp->block_size = block_size;
+	atomic_init(&tmp->write_count, 0);
+	tmp->read_count = 0;
+
+	return tmp;
+}
+
+float* br_begin_write(block_ring* br){
+	unsigned int slot = atomic_load_explicit(&br->write_count, memory_order_relaxed)
+						% br->slot_count;
+	unsigned int seq = atomic_load_explicit(&br->sequence[slot], memory_order_relaxed);
+
+	// mark the slot as being written before touching any sample
+	atomic_store_explicit(&br->sequence[slot], seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	return br->blocks + slot * br->block_size;
+}
+
+void br_end_write(block_ring* br){
+	unsigned int count = atomic_load_explicit(&br->write_count, memory_order_relaxed);
+	unsigned int slot = count % br->slot_count;
+	unsigned int seq = atomic_load_explicit(&br->sequence[slot], memory_order_relaxed);
+
+	atomic_store_explicit(&br->sequence[slot], seq + 1, memory_order_release);
+	atomic_store_explicit(&br->write_count, count + 1, memory_order_release);
+}
+
+bool br_read_latest(block_ring* br, float* dest){
+	unsigned int count = atomic_load_explicit(&br->write_count, memory_order_acquire);
+	unsigned int newest;
+	int age;
+
+	if (count == br->read_count){
+		return false;
+	}
+
+// Walk back from the newest block until one copies out cleanly
+///////////////////////////////////////////////////////////////
+	for (age = 1; age < br->slot_count && age <= (int)count; age++){
+		newest = count - age;
+		unsigned int slot = newest % br->slot_count;
+		unsigned int before = atomic_load_explicit(&br->sequence[slot], memory_order_acquire);
+
+		if (before & 1){
+			continue;	// producer is inside this slot right now
+		}
+
+		memcpy(dest, br->blocks + slot * br->block_size, br->block_size * sizeof(float));
+
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&br->sequence[slot], memory_order_relaxed) == before){
+			br->read_count = count;
+			return true;
+		}
+	}
+	return false;
+}
+
+void br_destroy(block_ring* br){
+	if (br == NULL){
+		return;
+	}
+	free(br->blocks);
+	free(br->sequence);
+	free(br);
+}
@@ -0,0 +1,39 @@
+// Block Ring Module
+//
+// Lock-free single-producer/single-consumer ring of fixed size sample
+// blocks. The audio thread publishes finished blocks and never waits;
+// the render thread copies out the newest complete block whenever it
+// draws. Every slot carries a sequence number, so a block that gets
+// overwritten while it is being copied is detected and skipped.
+
+#ifndef BLOCKRING_H
+#define BLOCKRING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+typedef struct _block_ring{
+	float* blocks;				// slot_count * block_size samples
+	atomic_uint* sequence;		// per slot, odd while the slot is written
+	int slot_count;
+	int block_size;
+	atomic_uint write_count;	// blocks published so far
+	unsigned int read_count;	// consumer: write_count at the last read
+}block_ring;
+
+block_ring* br_new(int slot_count, int block_size);
+
+// Producer: returns the slot to fill with block_size samples
+float* br_begin_write(block_ring* br);
+
+// Producer: publishes the slot returned by br_begin_write
+void br_end_write(block_ring* br);
+
+// Consumer: copies the newest complete block into dest. Returns false
+// (leaving dest untouched) if nothing new was published since the last
+// call or every recent slot was being overwritten.
+bool br_read_latest(block_ring* br, float* dest);
+
+void br_destroy(block_ring* br);
+
+#endif
@@ -0,0 +1,173 @@
+#include "CoefTable.h"
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI (3.141592654)
+#endif
+
+#define CT_TYPE_COUNT (HIGHSHELF + 1)
+
+// the first CT_TYPE_COUNT entries are every type at gain 0, in
+// FILTER_TYPES order, the rest are added under table_lock
+static coef_table tables[CT_MAX_TABLES];
+static int table_count = 0;
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 1 - cos and sin of i * pi / CT_TRIG_SIZE, shared by every table
+static float versine_table[CT_TRIG_SIZE + 1];
+static float sine_table[CT_TRIG_SIZE + 1];
+
+// Reads the weights off bq_design at a sample rate of 1. At omega 0,
+// pi and pi/2, 1 - cos and sin are 0 and 0, 2 and 0, 1 and 1; infinite
+// Q leaves out the sin / Q term and Q = 1 adds it once.
+static void ct_build(coef_table* ct){
+	double zero[6], nyquist[6], middle[6], middle_q[6];
+	biquad named;
+	int c;
+
+	bq_design(ct->filter_type, 0.0, INFINITY, ct->db_gain, 1, zero);
+	bq_design(ct->filter_type, 0.5, INFINITY, ct->db_gain, 1, nyquist);
+	bq_design(ct->filter_type, 0.25, INFINITY, ct->db_gain, 1, middle);
+	bq_design(ct->filter_type, 0.25, 1.0, ct->db_gain, 1, middle_q);
+	for (c = 0; c < 6; c++){
+		double versine = (nyquist[c] - zero[c]) / 2;
+		ct->weights[c][0] = (float)zero[c];
+		ct->weights[c][1] = (float)versine;
+		ct->weights[c][2] = (float)(middle[c] - zero[c] - versine);
+		ct->weights[c][3] = (float)(middle_q[c] - middle[c]);
+	}
+
+	bq_init(&named, ct->filter_type, 1000.f, 1.f, ct->db_gain, 44100);
+	ct->type = named.type;
+}
+
+// The shared table and every type at gain 0, once per process
+static void ct_build_tables(void){
+	int i;
+
+	for (i = 0; i <= CT_TRIG_SIZE; i++){
+		double omega = M_PI * i / CT_TRIG_SIZE;
+		versine_table[i] = (float)(2.0 * sin(omega / 2) * sin(omega / 2));
+		sine_table[i] = (float)sin(omega);
+	}
+	for (i = 0; i < CT_TYPE_COUNT; i++){
+		tables[i].filter_type = i;
+		tables[i].db_gain = 0.f;
+		ct_build(&tables[i]);
+	}
+	table_count = CT_TYPE_COUNT;
+}
+
+const coef_table* ct_get(int filter_type, float db_gain){
+	coef_table* ct = NULL;
+	int i;
+
+	pthread_once(&tables_once, ct_build_tables);
+	if (filter_type < 0 || filter_type >= CT_TYPE_COUNT){
+		return NULL;
+	}
+	if (filter_type != PEAK && filter_type != LOWSHELF && filter_type != HIGHSHELF){
+		db_gain = 0.f;
+	}
+	if (db_gain == 0.f){
+		return &tables[filter_type];
+	}
+
+	pthread_mutex_lock(&table_lock);
+	for (i = CT_TYPE_COUNT; i < table_count; i++){
+		if (tables[i].filter_type == filter_type && tables[i].db_gain == db_gain){
+			ct = &tables[i];
+			break;
+		}
+	}
+	if (ct == NULL && table_count == CT_MAX_TABLES){
+		printf("Error, no room for another coefficient table");
+	}
+	else if (ct == NULL){
+		ct = &tables[table_count];
+		ct->filter_type = filter_type;
+		ct->db_gain = db_gain;
+		ct_build(ct);
+		table_count++;
+	}
+	pthread_mutex_unlock(&table_lock);
+
+	return ct;
+}
+
+int ct_lookup(const coef_table* ct, float frequency, float q,
+				int sample_rate, float* coefficients){
+	float position, d, d2, versine_d, sine_d, versine, sine;
+	float inverse_q, inverse_a0, raw[6];
+	int index, c;
+
+	// NaN fails these too
+	if (!(frequency > 0.f && frequency <= 0.5f * sample_rate && q > 0.f)){
+		return 0;
+	}
+
+// 1 - cos and sin of omega: the nearest point below, plus the rest
+// d by angle addition. Series to d^4 and d^3 are exact in float.
+///////////////////////////////////////////////////////////////////
+	position = frequency * (2.f * CT_TRIG_SIZE) / sample_rate;
+	index = (int)position;
+	if (index > CT_TRIG_SIZE - 1){
+		index = CT_TRIG_SIZE - 1;
+	}
+	d = (position - index) * (float)(M_PI / CT_TRIG_SIZE);
+	d2 = d * d;
+	versine_d = d2 * (0.5f - d2 * (1.f / 24.f));
+	sine_d = d * (1.f - d2 * (1.f / 6.f));
+	versine = versine_table[index] * (1.f - versine_d) + versine_d
+			+ sine_table[index] * sine_d;
+	sine = sine_table[index] * (1.f - versine_d)
+			+ (1.f - versine_table[index]) * sine_d;
+
+// Weighted sums, then normalize to a0
+//////////////////////////////////////
+	inverse_q = 1.f / q;
+	for (c = 0; c < 6; c++){
+		const float* w = ct->weights[c];
+		raw[c] = w[0] + w[1] * versine + (w[2] + w[3] * inverse_q) * sine;
+	}
+	inverse_a0 = 1.f / raw[3];
+	coefficients[0] = raw[0] * inverse_a0;
+	coefficients[1] = raw[1] * inverse_a0;
+	coefficients[2] = raw[2] * inverse_a0;
+	coefficients[3] = raw[4] * inverse_a0;
+	coefficients[4] = raw[5] * inverse_a0;
+	return 1;
+}
+
+void ct_set_target(const coef_table* ct, biquad* bq,
+				float frequency, float q,
+				int sample_rate, int ramp_length){
+	float coefficients[5];
+	biquad next;
+
+	if ((bq->topology != BQ_DF1 && bq->topology != BQ_TDF2)
+		|| !ct_lookup(ct, frequency, q, sample_rate, coefficients)){
+		bq_set_target(bq, ct->filter_type, frequency, q, ct->db_gain,
+						sample_rate, ramp_length);
+		return;
+	}
+
+	// only what bq_glide_to reads for these two topologies
+	next.topology = bq->topology;
+	next.type = ct->type;
+	next.filter_type = ct->filter_type;
+	next.frequency = frequency;
+	next.q = q;
+	next.db_gain = ct->db_gain;
+	next.sample_rate = sample_rate;
+	next.a0 = 1.f;
+	next.b0 = coefficients[0];
+	next.b1 = coefficients[1];
+	next.b2 = coefficients[2];
+	next.a1 = coefficients[3];
+	next.a2 = coefficients[4];
+	bq_glide_to(bq, &next, ramp_length);
+}
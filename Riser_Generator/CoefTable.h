@@ -0,0 +1,63 @@
+// Coefficient Table Module
+//
+// Biquad coefficients without the pow, sin, cos and sqrt of bq_set_target,
+// so a cutoff can move every sample. Every coefficient of the RBJ
+// formulas (before normalizing to a0) is a weighted sum of 1,
+// 1 - cos(omega), sin(omega) and sin(omega) / Q, with weights that only
+// depend on the filter type and gain. A coef_table holds those weights
+// for one type and gain; 1 - cos and sin come from a table shared by all
+// of them.
+//
+// The shared table holds CT_TRIG_SIZE + 1 points from 0 to Nyquist and
+// is read between its points by angle addition, with the sine and cosine
+// of the remainder from their series. That is exact to float rounding,
+// so the grid can be uniform, and the index comes from a multiply rather
+// than a log. Q is exact as well. Keeping 1 - cos rather than cos keeps
+// the precision at low cutoffs that the float formulas lose.
+//
+// Tables are built by ct_get and shared read-only by every filter and
+// engine in the process. Every type at gain 0 is built, along with the
+// shared table, the first time any table is asked for; gains of the
+// peak and shelf types are built on first use under a lock. The weights
+// come from bq_design in double; "make bench" reports the error against
+// it next to that of the float formulas in bq_set_target.
+
+#ifndef COEFTABLE_H
+#define COEFTABLE_H
+
+#include "Biquad.h"
+
+// segments of the shared table between 0 and Nyquist
+#define CT_TRIG_SIZE 256
+
+// distinct filter type and gain pairs
+#define CT_MAX_TABLES 16
+
+typedef struct _coef_table{
+	int filter_type;
+	float db_gain;		// 0 for the types that do not use it
+	char* type;			// name as in biquad.type
+	// b0, b1, b2, a0, a1, a2 as weights of 1, 1 - cos(omega),
+	// sin(omega) and sin(omega) / Q
+	float weights[6][4];
+}coef_table;
+
+// The table of filter_type at db_gain. Safe to call from any thread, but
+// it may lock and run the trig, so not from the audio thread. Returns
+// NULL for an unknown type or if CT_MAX_TABLES are already in use.
+const coef_table* ct_get(int filter_type, float db_gain);
+
+// Coefficients for frequency and q into coefficients[5] as b0, b1, b2,
+// a1, a2, normalized to a0. Returns 0, leaving coefficients alone, if
+// frequency is not between 0 and Nyquist or q is not positive.
+int ct_lookup(const coef_table* ct, float frequency, float q,
+				int sample_rate, float* coefficients);
+
+// bq_set_target with the coefficients from ct. Falls back to
+// bq_set_target where ct_lookup fails and for the topologies that run on
+// double or SVF coefficients, which the table does not give.
+void ct_set_target(const coef_table* ct, biquad* bq,
+				float frequency, float q,
+				int sample_rate, int ramp_length);
+
+#endif
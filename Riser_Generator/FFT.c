@@ -0,0 +1,144 @@
+#include "FFT.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI (3.141592654)
+#endif
+
+#define cmp_abs(x) ( sqrt( (x).re * (x).re + (x).im * (x).im ) )
+
+fft* fft_new(int size){
+	int half = size / 2;
+	int bits = 0, k, b;
+	fft* tmp;
+
+	if (size < 4 || (size & (size - 1)) != 0){
+		printf("FFT size must be a power of two, got %d\n", size);
+		return NULL;
+	}
+
+	tmp = (fft*)malloc(sizeof(fft));
+	if (tmp == NULL){
+		printf("Error while allocating memory for fft");
+		return tmp;
+	}
+	tmp->size = size;
+	tmp->twiddle = NULL;
+	tmp->bitrev = NULL;
+	tmp->scratch = NULL;
+	tmp->spectrum = NULL;
+	tmp->twiddle = (complex*)malloc(half * sizeof(complex));
+	tmp->bitrev = (int*)malloc(half * sizeof(int));
+	tmp->scratch = (complex*)malloc((half + 1) * sizeof(complex));
+	tmp->spectrum = (complex*)malloc((half + 1) * sizeof(complex));
+	if (tmp->twiddle == NULL || tmp->bitrev == NULL || tmp->scratch == NULL
+		|| tmp->spectrum == NULL){
+		printf("Error while allocating memory for fft");
+		fft_destroy(tmp);
+		return NULL;
+	}
+
+// Precompute twiddles and the bit reversal permutation
+///////////////////////////////////////////////////////
+	for (k = 0; k < half; k++){
+		tmp->twiddle[k].re = (float)cos(2.0 * M_PI * k / size);
+		tmp->twiddle[k].im = (float)-sin(2.0 * M_PI * k / size);
+	}
+	while ((1 << bits) < half){
+		bits++;
+	}
+	for (k = 0; k < half; k++){
+		int r = 0;
+		for (b = 0; b < bits; b++){
+			r |= ((k >> b) & 1) << (bits - 1 - b);
+		}
+		tmp->bitrev[k] = r;
+	}
+
+	return tmp;
+}
+
+void fft_real(fft* f, const float* in, complex* out){
+	int half = f->size / 2;
+	complex* z = f->scratch;
+	int len, start, k;
+
+// Pack even samples as real and odd samples as imaginary parts,
+// in bit reversed order
+///////////////////////////////////////////////////////////////
+	for (k = 0; k < half; k++){
+		int r = f->bitrev[k];
+		z[r].re = in[2 * k];
+		z[r].im = in[2 * k + 1];
+	}
+
+// Iterative radix-2 butterflies. The size/2 point transform uses every
+// second twiddle of the size point table.
+//////////////////////////////////////////////////////////////////////
+	for (len = 2; len <= half; len <<= 1){
+		int stride = f->size / len;
+		for (start = 0; start < half; start += len){
+			for (k = 0; k < len / 2; k++){
+				complex w = f->twiddle[k * stride];
+				complex* a = &z[start + k];
+				complex* b = &z[start + k + len / 2];
+				float tre = b->re * w.re - b->im * w.im;
+				float tim = b->re * w.im + b->im * w.re;
+				b->re = a->re - tre;
+				b->im = a->im - tim;
+				a->re += tre;
+				a->im += tim;
+			}
+		}
+	}
+
+// Split into the spectrum of the real signal
+/////////////////////////////////////////////
+	z[half] = z[0];
+	for (k = 0; k <= half; k++){
+		complex zk = z[k];
+		complex zc = z[half - k];	// conjugated below
+		float ere = 0.5f * (zk.re + zc.re);
+		float eim = 0.5f * (zk.im - zc.im);
+		float ore = 0.5f * (zk.im + zc.im);
+		float oim = -0.5f * (zk.re - zc.re);
+		complex w;
+		if (k < half){
+			w = f->twiddle[k];
+		}
+		else{
+			w.re = -1.f;
+			w.im = 0.f;
+		}
+		out[k].re = ere + (ore * w.re - oim * w.im);
+		out[k].im = eim + (ore * w.im + oim * w.re);
+	}
+}
+
+void fft_magnitude_db(fft* f, const float* in, float* db,
+					float window_gain, float floor_db){
+	int half = f->size / 2;
+	float scale = 2.f / (f->size * window_gain);
+	int k;
+
+	fft_real(f, in, f->spectrum);
+
+	for (k = 0; k < half; k++){
+		float magnitude = cmp_abs(f->spectrum[k]) * scale;
+		float level = (magnitude > 0.f) ? 20.f * log10f(magnitude) : floor_db;
+		db[k] = (level < floor_db) ? floor_db : level;
+	}
+}
+
+void fft_destroy(fft* f){
+	if (f == NULL){
+		return;
+	}
+	free(f->twiddle);
+	free(f->bitrev);
+	free(f->scratch);
+	free(f->spectrum);
+	free(f);
+}
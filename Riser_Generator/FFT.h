@@ -0,0 +1,38 @@
+// FFT Module
+//
+// Radix-2 FFT for real input. A size N transform runs as a complex FFT
+// of size N/2 on the even/odd samples followed by a split step. Twiddles,
+// the bit reversal table and the scratch buffer are allocated in fft_new,
+// so transforms never allocate.
+
+#ifndef FFT_H
+#define FFT_H
+
+typedef struct _complex{
+	float re;
+	float im;
+}complex;
+
+typedef struct _fft{
+	int size;			// real input length, a power of two
+	complex* twiddle;	// e^(-2 pi i k / size) for k < size / 2
+	int* bitrev;		// bit reversal of k < size / 2
+	complex* scratch;	// size / 2 + 1 bins
+	complex* spectrum;	// output of fft_magnitude_db, size / 2 + 1 bins
+}fft;
+
+// Returns NULL if size is not a power of two (at least 4) or memory runs out
+fft* fft_new(int size);
+
+// Writes bins 0 .. size/2 of the spectrum of in to out
+void fft_real(fft* f, const float* in, complex* out);
+
+// Transforms in and writes size/2 magnitudes in dB to db, where 0 dB is a
+// full scale sine through a window with coherent gain window_gain
+// (sum of the window / size). Bins below floor_db are clamped to it.
+void fft_magnitude_db(fft* f, const float* in, float* db,
+					float window_gain, float floor_db);
+
+void fft_destroy(fft* f);
+
+#endif
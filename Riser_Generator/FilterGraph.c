@@ -0,0 +1,358 @@
+#include "FilterGraph.h"
+#include <stdio.h>
+#include <string.h>
+
+// Latest design of stage into its column of fg->target, from the
+// stage's table when the frequency is inside it
+static void fg_design(filter_graph* fg, int stage){
+	float coefficients[FG_COEFFICIENTS];
+	int k;
+
+	if (fg->table[stage] == NULL
+		|| !ct_lookup(fg->table[stage], fg->frequency[stage], fg->q[stage],
+						fg->sample_rate, coefficients)){
+		double design[6];
+		bq_design(fg->type[stage], fg->frequency[stage], fg->q[stage],
+					fg->db_gain[stage], fg->sample_rate, design);
+		coefficients[FG_B0] = design[0] / design[3];
+		coefficients[FG_B1] = design[1] / design[3];
+		coefficients[FG_B2] = design[2] / design[3];
+		coefficients[FG_A1] = design[4] / design[3];
+		coefficients[FG_A2] = design[5] / design[3];
+	}
+	for (k = 0; k < FG_COEFFICIENTS; k++){
+		fg->target[k][stage] = coefficients[k];
+	}
+}
+
+// Sets every stage gliding towards its target, as bq_glide_to does
+static void fg_start_glide(filter_graph* fg, int ramp_length){
+	int k, s;
+
+	for (k = 0; k < FG_COEFFICIENTS; k++){
+		for (s = 0; s < fg->stages; s++){
+			if (ramp_length <= 0){
+				fg->coefficient[k][s] = fg->target[k][s];
+			}
+			else{
+				fg->step[k][s] = (fg->target[k][s] - fg->coefficient[k][s]) / ramp_length;
+			}
+		}
+	}
+	fg->ramp_remaining = (ramp_length > 0) ? ramp_length : 0;
+}
+
+// One sample of the glide, the last one lands exactly on the targets
+static void fg_ramp_step(filter_graph* fg){
+	int k, s;
+
+	if (--fg->ramp_remaining == 0){
+		for (k = 0; k < FG_COEFFICIENTS; k++){
+			for (s = 0; s < fg->stages; s++){
+				fg->coefficient[k][s] = fg->target[k][s];
+			}
+		}
+	}
+	else{
+		for (k = 0; k < FG_COEFFICIENTS; k++){
+			for (s = 0; s < fg->stages; s++){
+				fg->coefficient[k][s] += fg->step[k][s];
+			}
+		}
+	}
+}
+
+static void fg_clear_stage(filter_graph* fg, int stage){
+	memset(fg->x1[stage], 0, sizeof(fg->x1[stage]));
+	memset(fg->x2[stage], 0, sizeof(fg->x2[stage]));
+	memset(fg->y1[stage], 0, sizeof(fg->y1[stage]));
+	memset(fg->y2[stage], 0, sizeof(fg->y2[stage]));
+}
+
+void fg_init(filter_graph* fg, int channels, int sample_rate){
+	if (channels > FG_MAX_CHANNELS){
+		channels = FG_MAX_CHANNELS;
+	}
+	fg->channels = channels;
+	fg->sample_rate = sample_rate;
+	fg_clear(fg);
+	fg_reset(fg);
+}
+
+int fg_add_stage(filter_graph* fg, int filter_type,
+				float frequency,
+				float q,
+				float dbGain){
+	int s = fg->stages;
+	int k;
+
+	if (s == FG_MAX_STAGES){
+		return -1;
+	}
+
+	fg->type[s] = filter_type;
+	fg->frequency[s] = frequency;
+	fg->ratio[s] = 0.f;
+	fg->q[s] = q;
+	fg->db_gain[s] = dbGain;
+	fg->table[s] = ct_get(filter_type, dbGain);
+	fg_design(fg, s);
+
+	// a running glide leaves the new stage where it is
+	for (k = 0; k < FG_COEFFICIENTS; k++){
+		fg->coefficient[k][s] = fg->target[k][s];
+		fg->step[k][s] = 0.f;
+	}
+	fg_clear_stage(fg, s);
+	fg->stages++;
+
+	return s;
+}
+
+void fg_set_stage(filter_graph* fg, int stage, int filter_type,
+				float frequency,
+				float q,
+				float dbGain,
+				int ramp_length){
+	// ct_get may lock, so a stage changing type or gain is designed
+	// exactly from then on
+	if (filter_type != fg->type[stage] || dbGain != fg->db_gain[stage]){
+		fg->table[stage] = NULL;
+	}
+	fg->type[stage] = filter_type;
+	fg->frequency[stage] = frequency;
+	fg->q[stage] = q;
+	fg->db_gain[stage] = dbGain;
+	fg_design(fg, stage);
+	fg_start_glide(fg, ramp_length);
+}
+
+void fg_follow(filter_graph* fg, int stage, float ratio){
+	fg->ratio[stage] = ratio;
+}
+
+void fg_set_base(filter_graph* fg, float frequency, int ramp_length){
+	float highest = FG_MAX_FREQUENCY * fg->sample_rate;
+	int changed = 0;
+	int s;
+
+	for (s = 0; s < fg->stages; s++){
+		float stage_frequency = fg->ratio[s] * frequency;
+
+		if (fg->ratio[s] <= 0.f){
+			continue;
+		}
+		if (stage_frequency < FG_MIN_FREQUENCY){
+			stage_frequency = FG_MIN_FREQUENCY;
+		}
+		if (stage_frequency > highest){
+			stage_frequency = highest;
+		}
+		if (stage_frequency != fg->frequency[s]){
+			fg->frequency[s] = stage_frequency;
+			fg_design(fg, s);
+			changed = 1;
+		}
+	}
+
+	// nothing moved, let a running glide finish as it was
+	if (changed){
+		fg_start_glide(fg, ramp_length);
+	}
+}
+
+void fg_glide_to(filter_graph* fg, const filter_graph* target, int ramp_length){
+	int k, s;
+
+	for (s = 0; s < target->stages; s++){
+		int fresh = (s >= fg->stages || fg->type[s] != target->type[s]);
+
+		fg->type[s] = target->type[s];
+		fg->frequency[s] = target->frequency[s];
+		fg->ratio[s] = target->ratio[s];
+		fg->q[s] = target->q[s];
+		fg->db_gain[s] = target->db_gain[s];
+		fg->table[s] = target->table[s];
+		for (k = 0; k < FG_COEFFICIENTS; k++){
+			fg->target[k][s] = target->coefficient[k][s];
+			if (fresh){
+				fg->coefficient[k][s] = target->coefficient[k][s];
+			}
+		}
+		if (fresh){
+			fg_clear_stage(fg, s);
+		}
+	}
+	fg->stages = target->stages;
+	fg_start_glide(fg, ramp_length);
+}
+
+void fg_clear(filter_graph* fg){
+	fg->stages = 0;
+	fg->ramp_remaining = 0;
+}
+
+void fg_reset(filter_graph* fg){
+	int s;
+	for (s = 0; s < FG_MAX_STAGES; s++){
+		fg_clear_stage(fg, s);
+	}
+}
+
+// One frame through every stage with the current coefficients, then one
+// step of the glide
+static void fg_process_frame(filter_graph* fg, const float* in, float* out){
+	float x[FG_MAX_CHANNELS];
+	int s, c;
+
+	for (c = 0; c < fg->channels; c++){
+		x[c] = in[c];
+	}
+	for (s = 0; s < fg->stages; s++){
+		float b0 = fg->coefficient[FG_B0][s], b1 = fg->coefficient[FG_B1][s];
+		float b2 = fg->coefficient[FG_B2][s];
+		float a1 = fg->coefficient[FG_A1][s], a2 = fg->coefficient[FG_A2][s];
+
+		for (c = 0; c < fg->channels; c++){
+			float y = (b0 * x[c]) + (b1 * fg->x1[s][c]) + (b2 * fg->x2[s][c])
+					- (a1 * fg->y1[s][c]) - (a2 * fg->y2[s][c]);
+			fg->x2[s][c] = fg->x1[s][c];
+			fg->x1[s][c] = x[c];
+			fg->y2[s][c] = fg->y1[s][c];
+			fg->y1[s][c] = y;
+			x[c] = y;
+		}
+	}
+	for (c = 0; c < fg->channels; c++){
+		out[c] = x[c];
+	}
+
+	fg_ramp_step(fg);
+}
+
+// frames through stage and the one after it with fixed coefficients, in
+// one loop so the two recursions overlap, history held in registers
+static void fg_process_pair(filter_graph* fg, int s,
+						const float* in, float* out, size_t frames){
+	float fb0 = fg->coefficient[FG_B0][s], fb1 = fg->coefficient[FG_B1][s];
+	float fb2 = fg->coefficient[FG_B2][s];
+	float fa1 = fg->coefficient[FG_A1][s], fa2 = fg->coefficient[FG_A2][s];
+	float sb0 = fg->coefficient[FG_B0][s + 1], sb1 = fg->coefficient[FG_B1][s + 1];
+	float sb2 = fg->coefficient[FG_B2][s + 1];
+	float sa1 = fg->coefficient[FG_A1][s + 1], sa2 = fg->coefficient[FG_A2][s + 1];
+	int channels = fg->channels;
+	size_t f;
+	int c;
+
+	for (c = 0; c < channels; c++){
+		float fx1 = fg->x1[s][c], fx2 = fg->x2[s][c];
+		float fy1 = fg->y1[s][c], fy2 = fg->y2[s][c];
+		float sx1 = fg->x1[s + 1][c], sx2 = fg->x2[s + 1][c];
+		float sy1 = fg->y1[s + 1][c], sy2 = fg->y2[s + 1][c];
+
+		for (f = 0; f < frames; f++){
+			float x = in[f * channels + c];
+			float m = (fb0 * x) + (fb1 * fx1) + (fb2 * fx2) - (fa1 * fy1) - (fa2 * fy2);
+			float y = (sb0 * m) + (sb1 * sx1) + (sb2 * sx2) - (sa1 * sy1) - (sa2 * sy2);
+			fx2 = fx1;
+			fx1 = x;
+			fy2 = fy1;
+			fy1 = m;
+			sx2 = sx1;
+			sx1 = m;
+			sy2 = sy1;
+			sy1 = y;
+			out[f * channels + c] = y;
+		}
+
+		fg->x1[s][c] = fx1;
+		fg->x2[s][c] = fx2;
+		fg->y1[s][c] = fy1;
+		fg->y2[s][c] = fy2;
+		fg->x1[s + 1][c] = sx1;
+		fg->x2[s + 1][c] = sx2;
+		fg->y1[s + 1][c] = sy1;
+		fg->y2[s + 1][c] = sy2;
+	}
+}
+
+// frames through one stage with fixed coefficients, history in registers
+static void fg_process_stage(filter_graph* fg, int s,
+						const float* in, float* out, size_t frames){
+	float b0 = fg->coefficient[FG_B0][s], b1 = fg->coefficient[FG_B1][s];
+	float b2 = fg->coefficient[FG_B2][s];
+	float a1 = fg->coefficient[FG_A1][s], a2 = fg->coefficient[FG_A2][s];
+	int channels = fg->channels;
+	size_t f;
+	int c;
+
+	for (c = 0; c < channels; c++){
+		float x1 = fg->x1[s][c], x2 = fg->x2[s][c];
+		float y1 = fg->y1[s][c], y2 = fg->y2[s][c];
+
+		for (f = 0; f < frames; f++){
+			float x = in[f * channels + c];
+			float y = (b0 * x) + (b1 * x1) + (b2 * x2) - (a1 * y1) - (a2 * y2);
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+			out[f * channels + c] = y;
+		}
+
+		fg->x1[s][c] = x1;
+		fg->x2[s][c] = x2;
+		fg->y1[s][c] = y1;
+		fg->y2[s][c] = y2;
+	}
+}
+
+void fg_process(filter_graph* fg, const float* in, float* out, size_t frames){
+	const float* source;
+	int channels = fg->channels;
+	size_t f = 0;
+	int s;
+
+	if (fg->stages == 0){
+		if (in != out){
+			memmove(out, in, frames * channels * sizeof(float));
+		}
+		return;
+	}
+
+// While the coefficients glide, a frame at a time through every stage
+//////////////////////////////////////////////////////////////////////
+	for (; f < frames && fg->ramp_remaining > 0; f++){
+		fg_process_frame(fg, in + f * channels, out + f * channels);
+	}
+
+// Fixed coefficients, one pass per pair of stages over the rest of the
+// block, and one for the odd stage left at the end
+////////////////////////////////////////////////////////////////////////
+	if (f == frames){
+		return;
+	}
+	source = in + f * channels;
+	for (s = 0; s + 1 < fg->stages; s += 2){
+		fg_process_pair(fg, s, source, out + f * channels, frames - f);
+		source = out + f * channels;
+	}
+	if (s < fg->stages){
+		fg_process_stage(fg, s, source, out + f * channels, frames - f);
+	}
+}
+
+void fg_print_info(filter_graph* fg){
+	int s;
+
+	printf("STAGES: %d, CHANNELS: %d\n", fg->stages, fg->channels);
+	for (s = 0; s < fg->stages; s++){
+		printf("%d: %s %.2f Hz (x%.3f) Q %.3f %.2f dB\n", s,
+				fg->table[s] != NULL ? fg->table[s]->type : "FILTER",
+				fg->frequency[s], fg->ratio[s], fg->q[s], fg->db_gain[s]);
+		printf("   B0 %.8f B1 %.8f B2 %.8f A1 %.8f A2 %.8f\n",
+				fg->coefficient[FG_B0][s], fg->coefficient[FG_B1][s],
+				fg->coefficient[FG_B2][s], fg->coefficient[FG_A1][s],
+				fg->coefficient[FG_A2][s]);
+	}
+}
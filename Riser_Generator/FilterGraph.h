@@ -0,0 +1,117 @@
+// Filter Graph Module
+//
+// An ordered cascade of up to FG_MAX_STAGES biquad stages, any of the
+// FILTER_TYPES each, over one or more interleaved channels. The
+// coefficients are stored as structure-of-arrays, one array per
+// coefficient indexed by stage, and the history as [stage][channel].
+// fg_process takes a whole block through every stage in one call: one
+// pass per pair of stages over the block, with their coefficients and
+// history held in registers and the two recursions overlapping, so an
+// extra stage costs a few multiplies a sample and no calls.
+//
+// Everything lives inside the struct and nothing allocates. Coefficients
+// come from the shared CoefTable tables, which fg_add_stage looks up with
+// ct_get, so stages are added before the audio thread starts. Redesigning,
+// retuning and clearing stages never locks and can run on the audio
+// thread; a stage that changes type or gain computes its design exactly.
+//
+// Stages follow a base frequency at a ratio (fg_follow, fg_set_base),
+// or keep their own. They run in direct form I in float and give the
+// same output as the same biquads chained with bq_process, glides
+// included.
+
+#ifndef FILTERGRAPH_H
+#define FILTERGRAPH_H
+
+#include <stddef.h>
+#include "Biquad.h"
+#include "CoefTable.h"
+
+#define FG_MAX_STAGES 8
+#define FG_MAX_CHANNELS 8
+
+// range a following stage is kept in, Hz and fraction of the sample rate
+#define FG_MIN_FREQUENCY 10.f
+#define FG_MAX_FREQUENCY 0.45f
+
+// rows of filter_graph.coefficient
+typedef enum {
+	FG_B0			= 0,
+	FG_B1			= 1,
+	FG_B2			= 2,
+	FG_A1			= 3,
+	FG_A2			= 4,
+	FG_COEFFICIENTS	= 5,
+} FG_COEFFICIENT_ROWS;
+
+typedef struct _filter_graph{
+	int stages;			// in use, the first ones
+	int channels;
+	int sample_rate;
+
+	// normalized to a0, [FG_B0 .. FG_A2][stage]
+	float coefficient[FG_COEFFICIENTS][FG_MAX_STAGES];
+	// glide of all stages towards their latest design, like biquad's
+	float target[FG_COEFFICIENTS][FG_MAX_STAGES];
+	float step[FG_COEFFICIENTS][FG_MAX_STAGES];
+	int ramp_remaining;
+
+	// design of each stage
+	int type[FG_MAX_STAGES];
+	float frequency[FG_MAX_STAGES];
+	float ratio[FG_MAX_STAGES];		// of the base frequency, 0 keeps frequency
+	float q[FG_MAX_STAGES];
+	float db_gain[FG_MAX_STAGES];
+	const coef_table* table[FG_MAX_STAGES];	// NULL computes the design exactly
+
+	// history, [stage][channel]
+	float x1[FG_MAX_STAGES][FG_MAX_CHANNELS];
+	float x2[FG_MAX_STAGES][FG_MAX_CHANNELS];
+	float y1[FG_MAX_STAGES][FG_MAX_CHANNELS];
+	float y2[FG_MAX_STAGES][FG_MAX_CHANNELS];
+}filter_graph;
+
+// Empty graph, it passes audio through unchanged
+void fg_init(filter_graph* fg, int channels, int sample_rate);
+
+// Appends a stage with clear history. Returns its index, or -1 if the
+// graph already has FG_MAX_STAGES.
+int fg_add_stage(filter_graph* fg, int filter_type,
+				float frequency,
+				float q,
+				float dbGain);
+
+// Redesigns stage without touching its history. The coefficients of
+// every stage glide to their latest design over ramp_length samples
+// (0 = jump immediately).
+void fg_set_stage(filter_graph* fg, int stage, int filter_type,
+				float frequency,
+				float q,
+				float dbGain,
+				int ramp_length);
+
+// Makes stage follow fg_set_base at ratio times the base frequency,
+// 0 stops it following
+void fg_follow(filter_graph* fg, int stage, float ratio);
+
+// Retunes every following stage to its ratio times frequency, kept
+// between FG_MIN_FREQUENCY and FG_MAX_FREQUENCY, gliding as fg_set_stage
+void fg_set_base(filter_graph* fg, float frequency, int ramp_length);
+
+// Glides fg towards the stages of target, which can be shared by many
+// graphs so the designs only run once. Stages that keep their type keep
+// their history; added or retyped ones start clear and jump.
+void fg_glide_to(filter_graph* fg, const filter_graph* target, int ramp_length);
+
+// Removes every stage
+void fg_clear(filter_graph* fg);
+
+// Clears the history of every stage
+void fg_reset(filter_graph* fg);
+
+// Filters frames of interleaved audio, in and out may be the same buffer
+void fg_process(filter_graph* fg, const float* in, float* out, size_t frames);
+
+void fg_print_info(filter_graph* fg);
+
+#endif
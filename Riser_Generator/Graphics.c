@@ -0,0 +1,484 @@
+#include "Graphics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI (3.141592654)
+#endif
+
+// Shaders
+//////////
+
+static const char* trace_vertex =
+	"#version 120\n"
+	"attribute float sample;\n"
+	"attribute float index;\n"
+	"uniform vec3 placement;\n"
+	"void main(){\n"
+	"	vec4 p = vec4(placement.x + index * placement.y, sample * placement.z, 0.0, 1.0);\n"
+	"	gl_FrontColor = gl_Color;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * p;\n"
+	"}\n";
+
+static const char* trace_fragment =
+	"#version 120\n"
+	"void main(){\n"
+	"	gl_FragColor = gl_Color;\n"
+	"}\n";
+
+static const char* waterfall_vertex =
+	"#version 120\n"
+	"attribute vec2 grid;\n"
+	"attribute float level;\n"
+	"uniform vec4 placement;\n"
+	"uniform vec4 ring;\n"
+	"varying float fade;\n"
+	"void main(){\n"
+	"	float age = mod(grid.y - ring.x + ring.y, ring.y);\n"
+	"	vec4 p = vec4(placement.x + grid.x * placement.y,\n"
+	"				(level - ring.z) * placement.w, -age * placement.z, 1.0);\n"
+	"	fade = level > ring.w ? 1.0 - age / ring.y : 0.0;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * p;\n"
+	"}\n";
+
+static const char* waterfall_fragment =
+	"#version 120\n"
+	"uniform vec3 color;\n"
+	"varying float fade;\n"
+	"void main(){\n"
+	"	if (fade <= 0.0) discard;\n"
+	"	gl_FragColor = vec4(color, fade);\n"
+	"}\n";
+
+// grid.x runs along the columns, grid.y from the newest row (0) to the
+// oldest (1). The texture row of an age is found from the head, texel
+// centres keep linear filtering off the seam between newest and oldest.
+static const char* spectrogram_vertex =
+	"#version 120\n"
+	"attribute vec2 grid;\n"
+	"uniform vec4 placement;\n"
+	"uniform vec4 ring;\n"
+	"varying vec2 texel;\n"
+	"varying float age;\n"
+	"void main(){\n"
+	"	age = grid.y;\n"
+	"	texel = vec2(grid.x, (ring.x + 0.5 + grid.y * (ring.y - 1.0)) / ring.y);\n"
+	"	vec4 p = vec4(placement.x + grid.x * placement.y, placement.w, -grid.y * placement.z, 1.0);\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * p;\n"
+	"}\n";
+
+// Dark blue through purple and orange to pale yellow
+static const char* spectrogram_fragment =
+	"#version 120\n"
+	"uniform sampler2D levels;\n"
+	"uniform vec4 ring;\n"
+	"uniform float range;\n"
+	"varying vec2 texel;\n"
+	"varying float age;\n"
+	"void main(){\n"
+	"	float level = texture2D(levels, texel).r;\n"
+	"	if (level <= ring.w) discard;\n"
+	"	float n = clamp((level - ring.z) / range, 0.0, 1.0);\n"
+	"	vec3 c = mix(vec3(0.0, 0.0, 0.1), vec3(0.5, 0.1, 0.6), smoothstep(0.0, 0.4, n));\n"
+	"	c = mix(c, vec3(1.0, 0.5, 0.1), smoothstep(0.4, 0.75, n));\n"
+	"	c = mix(c, vec3(1.0, 1.0, 0.7), smoothstep(0.75, 1.0, n));\n"
+	"	gl_FragColor = vec4(c, 1.0 - age);\n"
+	"}\n";
+
+static GLuint gfx_compile(GLenum type, const char* source){
+	GLint ok;
+	char log[1024];
+	GLuint shader = glCreateShader(type);
+
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok){
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		printf("Error while compiling shader: %s\n", log);
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+GLuint gfx_program(const char* vertex_source, const char* fragment_source){
+	GLint ok;
+	char log[1024];
+	GLuint vertex = gfx_compile(GL_VERTEX_SHADER, vertex_source);
+	GLuint fragment = gfx_compile(GL_FRAGMENT_SHADER, fragment_source);
+	GLuint program;
+
+	if (vertex == 0 || fragment == 0){
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+		return 0;
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	// attribute 0 aliases gl_Vertex and has to be the per-vertex one
+	glBindAttribLocation(program, 0, "grid");
+	glBindAttribLocation(program, 0, "sample");
+	glBindAttribLocation(program, 1, "level");
+	glBindAttribLocation(program, 1, "index");
+	glLinkProgram(program);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok){
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		printf("Error while linking shader program: %s\n", log);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// Waveform trace
+/////////////////
+
+gfx_trace* gfx_trace_new(int length){
+	int i;
+	float* index;
+	gfx_trace* tmp = (gfx_trace*)malloc(sizeof(gfx_trace));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for trace\n");
+		return tmp;
+	}
+	tmp->program = gfx_program(trace_vertex, trace_fragment);
+	if (tmp->program == 0){
+		free(tmp);
+		return NULL;
+	}
+	tmp->placement_uniform = glGetUniformLocation(tmp->program, "placement");
+	tmp->length = length;
+
+	index = (float*)malloc(length * sizeof(float));
+	if (index == NULL){
+		printf("Error while allocating memory for trace\n");
+		glDeleteProgram(tmp->program);
+		free(tmp);
+		return NULL;
+	}
+	for (i = 0; i < length; i++){
+		index[i] = (float)i;
+	}
+
+	glGenBuffers(1, &tmp->index_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tmp->index_buffer);
+	glBufferData(GL_ARRAY_BUFFER, length * sizeof(float), index, GL_STATIC_DRAW);
+	free(index);
+
+	glGenBuffers(1, &tmp->sample_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tmp->sample_buffer);
+	glBufferData(GL_ARRAY_BUFFER, length * sizeof(float), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return tmp;
+}
+
+void gfx_trace_draw(gfx_trace* trace, const float* samples,
+					float x, float xinc, float yscale){
+	glUseProgram(trace->program);
+	glUniform3f(trace->placement_uniform, x, xinc, yscale);
+
+	// orphan last frame's storage so the upload never waits for the GPU
+	glBindBuffer(GL_ARRAY_BUFFER, trace->sample_buffer);
+	glBufferData(GL_ARRAY_BUFFER, trace->length * sizeof(float), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, trace->length * sizeof(float), samples);
+	glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, trace->index_buffer);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(1);
+
+	glDrawArrays(GL_LINE_STRIP, 0, trace->length);
+
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+}
+
+void gfx_trace_destroy(gfx_trace* trace){
+	if (trace == NULL){
+		return;
+	}
+	glDeleteBuffers(1, &trace->index_buffer);
+	glDeleteBuffers(1, &trace->sample_buffer);
+	glDeleteProgram(trace->program);
+	free(trace);
+}
+
+// Circle
+/////////
+
+gfx_circle* gfx_circle_new(int points){
+	int i;
+	float* xy;
+	gfx_circle* tmp = (gfx_circle*)malloc(sizeof(gfx_circle));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for circle\n");
+		return tmp;
+	}
+	xy = (float*)malloc(2 * points * sizeof(float));
+	if (xy == NULL){
+		printf("Error while allocating memory for circle\n");
+		free(tmp);
+		return NULL;
+	}
+	for (i = 0; i < points; i++){
+		double angle = 2 * M_PI * i / points;
+		xy[2 * i] = (float)cos(angle);
+		xy[2 * i + 1] = (float)sin(angle);
+	}
+
+	tmp->points = points;
+	glGenBuffers(1, &tmp->buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tmp->buffer);
+	glBufferData(GL_ARRAY_BUFFER, 2 * points * sizeof(float), xy, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	free(xy);
+
+	return tmp;
+}
+
+void gfx_circle_draw(gfx_circle* circle){
+	glBindBuffer(GL_ARRAY_BUFFER, circle->buffer);
+	glVertexPointer(2, GL_FLOAT, 0, NULL);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glDrawArrays(GL_LINE_LOOP, 0, circle->points);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void gfx_circle_destroy(gfx_circle* circle){
+	if (circle == NULL){
+		return;
+	}
+	glDeleteBuffers(1, &circle->buffer);
+	free(circle);
+}
+
+// Waterfall
+////////////
+
+gfx_waterfall* gfx_waterfall_new(int depth, int width, float hidden_db){
+	int row, column, n;
+	int vertices = depth * width;
+	float* grid;
+	float* levels;
+	GLuint* indices;
+	gfx_waterfall* tmp = (gfx_waterfall*)malloc(sizeof(gfx_waterfall));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for waterfall\n");
+		return tmp;
+	}
+	tmp->program = gfx_program(waterfall_vertex, waterfall_fragment);
+	if (tmp->program == 0){
+		free(tmp);
+		return NULL;
+	}
+	tmp->placement_uniform = glGetUniformLocation(tmp->program, "placement");
+	tmp->ring_uniform = glGetUniformLocation(tmp->program, "ring");
+	tmp->color_uniform = glGetUniformLocation(tmp->program, "color");
+	tmp->depth = depth;
+	tmp->width = width;
+	tmp->index_count = depth * (width - 1) * 2;
+
+	grid = (float*)malloc(2 * vertices * sizeof(float));
+	levels = (float*)malloc(vertices * sizeof(float));
+	indices = (GLuint*)malloc(tmp->index_count * sizeof(GLuint));
+	if (grid == NULL || levels == NULL || indices == NULL){
+		printf("Error while allocating memory for waterfall\n");
+		free(grid);
+		free(levels);
+		free(indices);
+		glDeleteProgram(tmp->program);
+		free(tmp);
+		return NULL;
+	}
+
+	n = 0;
+	for (row = 0; row < depth; row++){
+		for (column = 0; column < width; column++){
+			int v = row * width + column;
+			grid[2 * v] = (float)column;
+			grid[2 * v + 1] = (float)row;
+			levels[v] = hidden_db;
+			if (column > 0){
+				indices[n++] = v - 1;
+				indices[n++] = v;
+			}
+		}
+	}
+
+	glGenBuffers(1, &tmp->grid_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tmp->grid_buffer);
+	glBufferData(GL_ARRAY_BUFFER, 2 * vertices * sizeof(float), grid, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &tmp->level_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tmp->level_buffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices * sizeof(float), levels, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &tmp->index_buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tmp->index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, tmp->index_count * sizeof(GLuint),
+				indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	free(grid);
+	free(levels);
+	free(indices);
+
+	return tmp;
+}
+
+void gfx_waterfall_push(gfx_waterfall* wf, int row, const float* levels){
+	glBindBuffer(GL_ARRAY_BUFFER, wf->level_buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, row * wf->width * sizeof(float),
+					wf->width * sizeof(float), levels);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void gfx_waterfall_draw(gfx_waterfall* wf, int head, float x, float xinc,
+						float zinc, float floor_db, float yscale, float hidden_db,
+						float r, float g, float b){
+	glUseProgram(wf->program);
+	glUniform4f(wf->placement_uniform, x, xinc, zinc, yscale);
+	glUniform4f(wf->ring_uniform, (float)head, (float)wf->depth, floor_db, hidden_db);
+	glUniform3f(wf->color_uniform, r, g, b);
+
+	glBindBuffer(GL_ARRAY_BUFFER, wf->grid_buffer);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, wf->level_buffer);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(1);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wf->index_buffer);
+	glDrawElements(GL_LINES, wf->index_count, GL_UNSIGNED_INT, NULL);
+
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+}
+
+void gfx_waterfall_destroy(gfx_waterfall* wf){
+	if (wf == NULL){
+		return;
+	}
+	glDeleteBuffers(1, &wf->grid_buffer);
+	glDeleteBuffers(1, &wf->level_buffer);
+	glDeleteBuffers(1, &wf->index_buffer);
+	glDeleteProgram(wf->program);
+	free(wf);
+}
+
+// Spectrogram
+//////////////
+
+gfx_spectrogram* gfx_spectrogram_new(int depth, int width, float hidden_db){
+	int i;
+	float* levels;
+	static const float quad[8] = { 0.f, 0.f, 1.f, 0.f, 1.f, 1.f, 0.f, 1.f };
+	gfx_spectrogram* tmp = (gfx_spectrogram*)malloc(sizeof(gfx_spectrogram));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for spectrogram\n");
+		return tmp;
+	}
+	tmp->program = gfx_program(spectrogram_vertex, spectrogram_fragment);
+	if (tmp->program == 0){
+		free(tmp);
+		return NULL;
+	}
+	tmp->placement_uniform = glGetUniformLocation(tmp->program, "placement");
+	tmp->ring_uniform = glGetUniformLocation(tmp->program, "ring");
+	tmp->range_uniform = glGetUniformLocation(tmp->program, "range");
+	tmp->levels_uniform = glGetUniformLocation(tmp->program, "levels");
+	tmp->depth = depth;
+	tmp->width = width;
+
+	levels = (float*)malloc(depth * width * sizeof(float));
+	if (levels == NULL){
+		printf("Error while allocating memory for spectrogram\n");
+		glDeleteProgram(tmp->program);
+		free(tmp);
+		return NULL;
+	}
+	for (i = 0; i < depth * width; i++){
+		levels[i] = hidden_db;
+	}
+
+	glGenTextures(1, &tmp->texture);
+	glBindTexture(GL_TEXTURE_2D, tmp->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE32F_ARB, width, depth, 0,
+				GL_LUMINANCE, GL_FLOAT, levels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	free(levels);
+
+	glGenBuffers(1, &tmp->quad_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tmp->quad_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return tmp;
+}
+
+void gfx_spectrogram_push(gfx_spectrogram* sg, int row, const float* levels){
+	glBindTexture(GL_TEXTURE_2D, sg->texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, sg->width, 1,
+					GL_LUMINANCE, GL_FLOAT, levels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void gfx_spectrogram_draw(gfx_spectrogram* sg, int head, float x, float xspan,
+						float zspan, float y, float floor_db, float range_db,
+						float hidden_db){
+	glUseProgram(sg->program);
+	glUniform4f(sg->placement_uniform, x, xspan, zspan, y);
+	glUniform4f(sg->ring_uniform, (float)head, (float)sg->depth, floor_db, hidden_db);
+	glUniform1f(sg->range_uniform, range_db);
+	glUniform1i(sg->levels_uniform, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, sg->texture);
+
+	glBindBuffer(GL_ARRAY_BUFFER, sg->quad_buffer);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+
+	glDrawArrays(GL_QUADS, 0, 4);
+
+	glDisableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+}
+
+void gfx_spectrogram_destroy(gfx_spectrogram* sg){
+	if (sg == NULL){
+		return;
+	}
+	glDeleteTextures(1, &sg->texture);
+	glDeleteBuffers(1, &sg->quad_buffer);
+	glDeleteProgram(sg->program);
+	free(sg);
+}
@@ -0,0 +1,112 @@
+// Graphics Module
+//
+// Retained mode drawing for the riser generator's display. Geometry that
+// never changes is uploaded once; per-frame data is streamed into vertex
+// buffers and positioned by small GLSL 1.20 shaders, so every element is
+// a single draw call. The shaders use the fixed function matrix stack,
+// so glTranslatef/glRotatef around the draws keep working.
+
+#ifndef GRAPHICS_H
+#define GRAPHICS_H
+
+#ifdef __MACOSX_CORE__
+#include <GLUT/glut.h>
+#else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glut.h>
+#endif
+
+#ifndef GL_LUMINANCE32F_ARB
+#define GL_LUMINANCE32F_ARB 0x8818
+#endif
+
+// Line strip through a block of samples
+typedef struct _gfx_trace{
+	GLuint program;
+	GLuint index_buffer;		// vertex numbers 0 .. length-1, static
+	GLuint sample_buffer;		// orphaned and refilled every frame
+	GLint placement_uniform;	// x of the first sample, x step, y scale
+	int length;
+}gfx_trace;
+
+// Unit circle outline, built once
+typedef struct _gfx_circle{
+	GLuint buffer;
+	int points;
+}gfx_circle;
+
+// Spectrum waterfall. The level buffer has the same ring layout as the
+// history: a pushed row overwrites the oldest one in place and the
+// vertex shader turns a row's distance from the head into depth and fade.
+typedef struct _gfx_waterfall{
+	GLuint program;
+	GLuint grid_buffer;			// column, row of every vertex, static
+	GLuint level_buffer;		// depth * width dB levels, one row per push
+	GLuint index_buffer;		// GL_LINES pairs inside each row, static
+	GLint placement_uniform;	// x of column 0, x step, z step, y per dB
+	GLint ring_uniform;			// head row, depth, floor dB, hidden dB
+	GLint color_uniform;
+	int depth;
+	int width;
+	int index_count;
+}gfx_waterfall;
+
+// Spectrogram, the same ring kept in one float texture with a row per
+// push. It is drawn as a single quad lying under the spectrum, colored by
+// a colormap in the fragment shader, so a deeper history only costs
+// texture memory.
+typedef struct _gfx_spectrogram{
+	GLuint program;
+	GLuint texture;				// width x depth dB levels, GL_REPEAT along the rows
+	GLuint quad_buffer;			// corners of the unit quad, static
+	GLint placement_uniform;	// x of column 0, x span, z span, y
+	GLint ring_uniform;			// head row, depth, floor dB, hidden dB
+	GLint range_uniform;		// dB from the floor to the top of the colormap
+	GLint levels_uniform;
+	int depth;
+	int width;
+}gfx_spectrogram;
+
+// Compiles and links a program with grid/sample bound to attribute 0 and
+// level to attribute 1. Prints the info log and returns 0 on errors.
+GLuint gfx_program(const char* vertex_source, const char* fragment_source);
+
+gfx_trace* gfx_trace_new(int length);
+void gfx_trace_draw(gfx_trace* trace, const float* samples,
+					float x, float xinc, float yscale);
+void gfx_trace_destroy(gfx_trace* trace);
+
+gfx_circle* gfx_circle_new(int points);
+void gfx_circle_draw(gfx_circle* circle);
+void gfx_circle_destroy(gfx_circle* circle);
+
+// Every level starts at hidden_db, rows at or below it are not drawn
+gfx_waterfall* gfx_waterfall_new(int depth, int width, float hidden_db);
+
+// Uploads width levels into ring row
+void gfx_waterfall_push(gfx_waterfall* wf, int row, const float* levels);
+
+// Draws the history with row head in front
+void gfx_waterfall_draw(gfx_waterfall* wf, int head, float x, float xinc,
+						float zinc, float floor_db, float yscale, float hidden_db,
+						float r, float g, float b);
+void gfx_waterfall_destroy(gfx_waterfall* wf);
+
+// Every level starts at hidden_db, texels at or below it are not drawn
+gfx_spectrogram* gfx_spectrogram_new(int depth, int width, float hidden_db);
+
+// Uploads width levels into texture row
+void gfx_spectrogram_push(gfx_spectrogram* sg, int row, const float* levels);
+
+// Draws the history between x and x + xspan with row head at z = 0 and
+// the oldest row at z = -zspan
+void gfx_spectrogram_draw(gfx_spectrogram* sg, int head, float x, float xspan,
+						float zspan, float y, float floor_db, float range_db,
+						float hidden_db);
+void gfx_spectrogram_destroy(gfx_spectrogram* sg);
+
+#endif
@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+#include "JobPool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#endif
+
+#define JP_SPINS 2000		// polls before a waiting worker starts yielding
+#define JP_YIELDS 200		// yields before it starts sleeping
+#define JP_SLEEP_NS 50000	// sleep between polls after that
+#define JP_SLEEPS 2000		// sleeps, 100 ms or more, before it parks
+
+static inline unsigned long long pack_range(unsigned int next, unsigned int end){
+	return ((unsigned long long)end << 32) | next;
+}
+
+// Claims one job from ranges[r], returns -1 if it is used up
+static inline int claim(job_pool* jp, int r){
+	atomic_ullong* range = &jp->ranges[r].range;
+	unsigned long long value = atomic_load_explicit(range, memory_order_acquire);
+
+	for (;;){
+		unsigned int next = (unsigned int)value;
+		unsigned int end = (unsigned int)(value >> 32);
+		if (next >= end){
+			return -1;
+		}
+		if (atomic_compare_exchange_weak_explicit(range, &value, value + 1,
+				memory_order_acq_rel, memory_order_acquire)){
+			return (int)next;
+		}
+	}
+}
+
+// Runs jobs from range own until it is empty, then steals from the others
+static void work(job_pool* jp, int own){
+	int participants = jp->worker_count + 1;
+	int r, k, job;
+
+	for (k = 0; k < participants; k++){
+		r = (own + k) % participants;
+		while ((job = claim(jp, r)) >= 0){
+			jp->function(jp->context, job);
+			atomic_fetch_sub_explicit(&jp->pending, 1, memory_order_release);
+		}
+	}
+}
+
+static void* worker_main(void* arg){
+	job_worker* me = (job_worker*)arg;
+	job_pool* jp = me->jp;
+	unsigned int seen = atomic_load(&jp->generation);
+	int polls = 0;
+
+	while (atomic_load_explicit(&jp->running, memory_order_relaxed)){
+		unsigned int generation = atomic_load_explicit(&jp->generation, memory_order_acquire);
+
+		if (generation != seen){
+			seen = generation;
+			polls = 0;
+			work(jp, me->index);
+			continue;
+		}
+
+// Nothing to do: spin, then yield, then sleep, then park
+/////////////////////////////////////////////////////////
+		polls++;
+		if (polls < JP_SPINS){
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#endif
+		}
+		else if (polls < JP_SPINS + JP_YIELDS){
+			sched_yield();
+		}
+		else if (polls < JP_SPINS + JP_YIELDS + JP_SLEEPS){
+			struct timespec pause = {0, JP_SLEEP_NS};
+			nanosleep(&pause, NULL);
+		}
+		else{
+			// idle for longer than any callback period, wait for jp_run
+			pthread_mutex_lock(&jp->park_lock);
+			atomic_fetch_add(&jp->parked, 1);
+			while (atomic_load(&jp->generation) == seen
+					&& atomic_load(&jp->running)){
+				pthread_cond_wait(&jp->park_signal, &jp->park_lock);
+			}
+			atomic_fetch_sub(&jp->parked, 1);
+			pthread_mutex_unlock(&jp->park_lock);
+			polls = 0;
+		}
+	}
+	return NULL;
+}
+
+job_pool* jp_new(int worker_count, bool pin){
+	int i;
+	job_pool* tmp = (job_pool*)aligned_alloc(64, sizeof(job_pool));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for job pool");
+		return tmp;
+	}
+
+	if (worker_count > JP_MAX_WORKERS){
+		worker_count = JP_MAX_WORKERS;
+	}
+	for (i = 0; i <= JP_MAX_WORKERS; i++){
+		atomic_init(&tmp->ranges[i].range, 0);
+	}
+	tmp->worker_count = 0;
+	tmp->function = NULL;
+	tmp->context = NULL;
+	atomic_init(&tmp->pending, 0);
+	atomic_init(&tmp->generation, 0);
+	atomic_init(&tmp->running, true);
+	atomic_init(&tmp->parked, 0);
+	pthread_mutex_init(&tmp->park_lock, NULL);
+	pthread_cond_init(&tmp->park_signal, NULL);
+
+	for (i = 0; i < worker_count; i++){
+		tmp->workers[i].jp = tmp;
+		tmp->workers[i].index = i;
+		if (pthread_create(&tmp->threads[i], NULL, worker_main, &tmp->workers[i]) != 0){
+			printf("Error while starting job pool worker %d\n", i);
+			jp_destroy(tmp);
+			return NULL;
+		}
+		tmp->worker_count++;
+
+#ifdef __linux__
+		// core 0 is left to the audio and GUI threads
+		if (pin){
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET((i + 1) % CPU_SETSIZE, &cpus);
+			pthread_setaffinity_np(tmp->threads[i], sizeof(cpus), &cpus);
+		}
+#elif defined(__APPLE__)
+		// macOS has no hard affinity, distinct tags ask the scheduler to
+		// keep the workers apart and off the tag 0 threads
+		if (pin){
+			thread_affinity_policy_data_t policy = { i + 1 };
+			thread_policy_set(pthread_mach_thread_np(tmp->threads[i]),
+						THREAD_AFFINITY_POLICY, (thread_policy_t)&policy,
+						THREAD_AFFINITY_POLICY_COUNT);
+		}
+#endif
+	}
+
+	return tmp;
+}
+
+void jp_run(job_pool* jp, job_function function, void* context, int job_count){
+	int participants = jp->worker_count + 1;
+	int r, start = 0;
+
+	if (job_count <= 0){
+		return;
+	}
+
+	jp->function = function;
+	jp->context = context;
+	atomic_store_explicit(&jp->pending, job_count, memory_order_relaxed);
+
+// Even split, the caller's range is the last one
+////////////////////////////////////////////////
+	for (r = 0; r < participants; r++){
+		int count = job_count / participants + (r < job_count % participants);
+		atomic_store_explicit(&jp->ranges[r].range,
+							pack_range(start, start + count), memory_order_release);
+		start += count;
+	}
+	atomic_fetch_add(&jp->generation, 1);
+
+	// Parked workers are woken only if that doesn't wait on a worker
+	// that is parking; one that misses the batch is woken by the next
+	if (atomic_load(&jp->parked) > 0
+			&& pthread_mutex_trylock(&jp->park_lock) == 0){
+		pthread_cond_broadcast(&jp->park_signal);
+		pthread_mutex_unlock(&jp->park_lock);
+	}
+
+	work(jp, participants - 1);
+
+	// lock-free join
+	while (atomic_load_explicit(&jp->pending, memory_order_acquire) > 0){
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+}
+
+void jp_destroy(job_pool* jp){
+	int i;
+
+	if (jp == NULL){
+		return;
+	}
+	atomic_store(&jp->running, false);
+	pthread_mutex_lock(&jp->park_lock);
+	pthread_cond_broadcast(&jp->park_signal);
+	pthread_mutex_unlock(&jp->park_lock);
+	for (i = 0; i < jp->worker_count; i++){
+		pthread_join(jp->threads[i], NULL);
+	}
+	pthread_cond_destroy(&jp->park_signal);
+	pthread_mutex_destroy(&jp->park_lock);
+	free(jp);
+}
@@ -0,0 +1,62 @@
+// Job Pool Module
+//
+// Worker threads that help the calling thread run a batch of
+// independent jobs. The batch is split into one contiguous range per
+// participant; whoever runs out of work steals from the other ranges.
+// Claiming a job is a single compare-and-swap and joining is a spin on
+// an atomic counter, so jp_run never waits on a lock and never
+// allocates. The caller always takes part, so a batch completes even
+// while every worker is still asleep. Workers idle for longer than a
+// callback period park on a condition variable and cost nothing until
+// the next batch.
+
+#ifndef JOBPOOL_H
+#define JOBPOOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define JP_MAX_WORKERS 32
+
+typedef void (*job_function)(void* context, int job);
+
+typedef struct _job_range{
+	// next job in the low 32 bits, end of the range in the high 32 bits,
+	// so a claim sees both from the same batch
+	_Alignas(64) atomic_ullong range;
+}job_range;
+
+typedef struct _job_worker{
+	struct _job_pool* jp;
+	int index;				// range the worker starts on
+}job_worker;
+
+typedef struct _job_pool{
+	job_range ranges[JP_MAX_WORKERS + 1];	// one per worker, last is the caller
+	pthread_t threads[JP_MAX_WORKERS];
+	job_worker workers[JP_MAX_WORKERS];
+	int worker_count;
+	job_function function;
+	void* context;
+	atomic_int pending;			// jobs of the current batch not finished
+	atomic_uint generation;		// bumped when a batch is published
+	atomic_bool running;
+	atomic_int parked;			// workers waiting on park_signal
+	pthread_mutex_t park_lock;
+	pthread_cond_t park_signal;
+}job_pool;
+
+// Starts worker_count threads, pinned to cores 1..worker_count when pin
+// is set. On macOS pinning is an affinity tag per worker, a hint the
+// scheduler may ignore (Apple silicon does). Returns NULL if a thread
+// can't be started.
+job_pool* jp_new(int worker_count, bool pin);
+
+// Runs function(context, job) for job = 0 .. job_count - 1 and returns
+// when all of them are done. Only one thread may call jp_run at a time.
+void jp_run(job_pool* jp, job_function function, void* context, int job_count);
+
+void jp_destroy(job_pool* jp);
+
+#endif
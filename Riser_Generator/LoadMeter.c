@@ -0,0 +1,103 @@
+#include "LoadMeter.h"
+#include <stdio.h>
+#include <time.h>
+
+void lm_init(load_meter* lm){
+	int i;
+	for (i = 0; i <= LM_BINS; i++){
+		atomic_init(&lm->histogram[i], 0);
+	}
+	atomic_init(&lm->callbacks, 0);
+	atomic_init(&lm->load_sum, 0);
+	atomic_init(&lm->frames, 0);
+	atomic_init(&lm->underflows, 0);
+}
+
+unsigned long long lm_now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void lm_record(load_meter* lm, unsigned long long start_ns,
+				unsigned long frames, int sample_rate, int underflow){
+	double elapsed = (double)(lm_now_ns() - start_ns) * 1e-9;
+	double load = elapsed * sample_rate / frames;
+	int bin = (int)(load / LM_BIN_WIDTH);
+
+	if (bin > LM_BINS){
+		bin = LM_BINS;
+	}
+	atomic_fetch_add_explicit(&lm->histogram[bin], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&lm->load_sum, (unsigned long long)(load * 1e6),
+								memory_order_relaxed);
+	atomic_fetch_add_explicit(&lm->frames, frames, memory_order_relaxed);
+	if (underflow){
+		atomic_fetch_add_explicit(&lm->underflows, 1, memory_order_relaxed);
+	}
+	// published last, a reader that sees the count sees the rest
+	atomic_fetch_add_explicit(&lm->callbacks, 1, memory_order_release);
+}
+
+void lm_snapshot(load_meter* lm, load_snapshot* snapshot){
+	int i;
+	snapshot->callbacks = atomic_load_explicit(&lm->callbacks, memory_order_acquire);
+	for (i = 0; i <= LM_BINS; i++){
+		snapshot->histogram[i] = atomic_load_explicit(&lm->histogram[i],
+														memory_order_relaxed);
+	}
+	snapshot->load_sum = atomic_load_explicit(&lm->load_sum, memory_order_relaxed);
+	snapshot->frames = atomic_load_explicit(&lm->frames, memory_order_relaxed);
+	snapshot->underflows = atomic_load_explicit(&lm->underflows, memory_order_relaxed);
+}
+
+void lm_report(const load_snapshot* before, const load_snapshot* after,
+				load_report* report){
+	unsigned long long count = 0, p99_count, seen = 0;
+	int i, first = -1, last = -1, p99 = -1;
+
+	// counts from the histogram, callbacks may run ahead of it
+	for (i = 0; i <= LM_BINS; i++){
+		unsigned int n = after->histogram[i] - before->histogram[i];
+		if (n > 0){
+			if (first < 0){
+				first = i;
+			}
+			last = i;
+			count += n;
+		}
+	}
+
+	report->callbacks = after->callbacks - before->callbacks;
+	report->underflows = after->underflows - before->underflows;
+	report->min = report->avg = report->p99 = report->max = 0.;
+	report->block_size = report->callbacks > 0
+		? (int)((after->frames - before->frames) / report->callbacks) : 0;
+	if (count == 0){
+		return;
+	}
+
+	p99_count = count - count / 100;
+	for (i = first; i <= last; i++){
+		seen += after->histogram[i] - before->histogram[i];
+		if (seen >= p99_count){
+			p99 = i;
+			break;
+		}
+	}
+
+	// p99 and max at the upper edge of their bins, so they never
+	// understate the load
+	report->min = first * LM_BIN_WIDTH;
+	report->p99 = (p99 + 1) * LM_BIN_WIDTH;
+	report->max = (last + 1) * LM_BIN_WIDTH;
+	report->avg = (after->load_sum - before->load_sum) * 1e-6 / count;
+}
+
+void lm_print(const load_report* report){
+	printf("[RISER GENERATOR]: %llu blocks of %d, DSP load min %.1f%% avg %.1f%% "
+			"p99 %.1f%% max %.1f%%, %u underflows\n",
+			report->callbacks, report->block_size,
+			report->min * 100., report->avg * 100.,
+			report->p99 * 100., report->max * 100., report->underflows);
+}
@@ -0,0 +1,68 @@
+// Load Meter Module
+//
+// Callback instrumentation. The audio thread records how long each block
+// took to render, as a fraction of the time the block lasts, into a
+// histogram of atomic counters: recording is a handful of relaxed atomic
+// adds, no locks and no allocation. Readers take snapshots and compare
+// two of them, so the overlay and the console dump can each report over
+// their own interval without resetting anything the audio thread uses.
+
+#ifndef LOADMETER_H
+#define LOADMETER_H
+
+#include <stdatomic.h>
+
+// load histogram, LM_BINS bins of LM_BIN_WIDTH plus one for everything
+// above LM_BINS * LM_BIN_WIDTH
+#define LM_BINS 400
+#define LM_BIN_WIDTH 0.005
+
+typedef struct _load_meter{
+	atomic_uint histogram[LM_BINS + 1];
+	atomic_ullong callbacks;
+	atomic_ullong load_sum;		// sum of the loads, in millionths
+	atomic_ullong frames;
+	atomic_uint underflows;		// callbacks flagged paOutputUnderflow
+}load_meter;
+
+typedef struct _load_snapshot{
+	unsigned int histogram[LM_BINS + 1];
+	unsigned long long callbacks;
+	unsigned long long load_sum;
+	unsigned long long frames;
+	unsigned int underflows;
+}load_snapshot;
+
+// Loads are fractions of the block period, 1 = the deadline
+typedef struct _load_report{
+	unsigned long long callbacks;
+	double min;
+	double avg;
+	double p99;
+	double max;
+	unsigned int underflows;
+	int block_size;				// average frames per callback
+}load_report;
+
+void lm_init(load_meter* lm);
+
+// Monotonic clock in nanoseconds
+unsigned long long lm_now_ns(void);
+
+// Audio thread: one callback that started at start_ns and rendered
+// frames at sample_rate
+void lm_record(load_meter* lm, unsigned long long start_ns,
+				unsigned long frames, int sample_rate, int underflow);
+
+void lm_snapshot(load_meter* lm, load_snapshot* snapshot);
+
+// Statistics of the callbacks between two snapshots. Min, p99 and max
+// are resolved to LM_BIN_WIDTH (min rounded down, the others up), the
+// average is exact.
+void lm_report(const load_snapshot* before, const load_snapshot* after,
+				load_report* report);
+
+// One line to the console
+void lm_print(const load_report* report);
+
+#endif
@@ -0,0 +1,214 @@
+#include "Oscillator.h"
+#include <math.h>
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI (3.141592654)
+#endif
+
+#define SINE_TABLE_SIZE 1024
+
+// one cycle of sine plus a guard point for the interpolation
+static float sine_table[SINE_TABLE_SIZE + 1];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void osc_build_tables(void){
+	int i;
+	for (i = 0; i <= SINE_TABLE_SIZE; i++){
+		sine_table[i] = (float)sin(2.0 * M_PI * i / SINE_TABLE_SIZE);
+	}
+}
+
+static inline float sine_lookup(double t){
+	double pos = t * SINE_TABLE_SIZE;
+	int index = (int)pos;
+	float frac = (float)(pos - index);
+	return sine_table[index] + frac * (sine_table[index + 1] - sine_table[index]);
+}
+
+// sin(2 * pi * t) for t in [0, 1). Folds t onto a quarter wave and
+// evaluates a degree 9 odd minimax polynomial, max error about 1e-7.
+static inline float sine_poly(double t){
+	float u = (float)t - 0.5f;	// sin(2 pi t) = -sin(2 pi u)
+	float x, x2;
+
+	if (u > 0.25f){
+		u = 0.5f - u;
+	}
+	else if (u < -0.25f){
+		u = -0.5f - u;
+	}
+	x = (float)(2.0 * M_PI) * u;
+	x2 = x * x;
+	return -x * (1.0f + x2 * (-0.16666666f + x2 * (0.0083333310f
+				+ x2 * (-0.00019840874f + x2 * 2.7525562e-6f))));
+}
+
+// Residual of a band-limited step of height 2, spread over one sample
+// on each side of the discontinuity at t = 0
+static inline double poly_blep(double t, double dt){
+	if (t < dt){
+		t /= dt;
+		return t + t - t * t - 1.0;
+	}
+	else if (t > 1.0 - dt){
+		t = (t - 1.0) / dt;
+		return t * t + t + t + 1.0;
+	}
+	return 0.0;
+}
+
+// Integral of poly_blep: residual of a band-limited corner where the
+// slope changes by 2 per sample
+static inline double poly_blamp(double t, double dt){
+	if (t < dt){
+		t = t / dt - 1.0;
+		return -1.0 / 3.0 * t * t * t;
+	}
+	else if (t > 1.0 - dt){
+		t = (t - 1.0) / dt + 1.0;
+		return 1.0 / 3.0 * t * t * t;
+	}
+	return 0.0;
+}
+
+void osc_prepare_tables(void){
+	pthread_once(&tables_once, osc_build_tables);
+}
+
+void osc_init(oscillator* osc, int waveform,
+				float frequency,
+				int sample_rate){
+	osc_prepare_tables();
+	osc->phase = 0.0;
+	osc->waveform = waveform;
+	osc->increment = -1.0;
+	osc_set_sine_mode(osc, SINE_LIBM);
+	osc_set_frequency(osc, frequency, sample_rate);
+}
+
+void osc_set_sine_mode(oscillator* osc, int sine_mode){
+	osc->sine_mode = sine_mode;
+
+	// start the phasor where the phase accumulator is
+	osc->quad_cos = cos(2.0 * M_PI * osc->phase);
+	osc->quad_sin = sin(2.0 * M_PI * osc->phase);
+}
+
+const char* osc_sine_mode_name(int sine_mode){
+	switch (sine_mode){
+		case SINE_LIBM:
+			return "LIBM";
+		case SINE_TABLE:
+			return "TABLE";
+		case SINE_POLY:
+			return "POLY";
+		case SINE_QUADRATURE:
+			return "QUADRATURE";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+void osc_set_frequency(oscillator* osc, float frequency, int sample_rate){
+	double inc = (double)frequency / sample_rate;
+
+	// the corrections assume less than half a cycle per sample
+	if (inc < 0.0){
+		inc = 0.0;
+	}
+	if (inc > 0.49){
+		inc = 0.49;
+	}
+	if (inc == osc->increment){
+		return;
+	}
+	osc->increment = inc;
+
+	// per-sample rotation of the quadrature phasor
+	osc->rot_cos = cos(2.0 * M_PI * inc);
+	osc->rot_sin = sin(2.0 * M_PI * inc);
+}
+
+// Next sample of the selected sine implementation at phase t
+static inline float osc_sine(oscillator* osc, double t){
+	double c, s, gain;
+
+	switch (osc->sine_mode){
+		case SINE_TABLE:
+			return sine_lookup(t);
+
+		case SINE_POLY:
+			return sine_poly(t);
+
+		case SINE_QUADRATURE:
+			s = osc->quad_sin;
+			c = osc->quad_cos;
+			osc->quad_cos = c * osc->rot_cos - s * osc->rot_sin;
+			osc->quad_sin = s * osc->rot_cos + c * osc->rot_sin;
+			// pull the phasor back onto the unit circle
+			gain = 1.5 - 0.5 * (osc->quad_cos * osc->quad_cos
+								+ osc->quad_sin * osc->quad_sin);
+			osc->quad_cos *= gain;
+			osc->quad_sin *= gain;
+			return (float)s;
+
+		default:
+			return (float)sin(2.0 * M_PI * t);
+	}
+}
+
+float osc_process(oscillator* osc){
+	double t = osc->phase;
+	double dt = osc->increment;
+	double half = t + 0.5;
+	double value;
+
+	if (half >= 1.0){
+		half -= 1.0;
+	}
+
+	switch (osc->waveform){
+		case OSC_SINE:
+			value = osc_sine(osc, t);
+			break;
+
+		case OSC_TRI:
+			//corners at t = 0 (minimum) and t = 0.5 (maximum)
+			value = 1.0 - 4.0 * fabs(t - 0.5);
+			value += 4.0 * dt * (poly_blamp(t, dt) - poly_blamp(half, dt));
+			break;
+
+		case OSC_SAW:
+			value = 2.0 * t - 1.0;
+			value -= poly_blep(t, dt);
+			break;
+
+		case OSC_SQUARE:
+			value = (t < 0.5) ? 1.0 : -1.0;
+			value += poly_blep(t, dt);
+			value -= poly_blep(half, dt);
+			break;
+
+		default:
+			value = 0.0;
+			break;
+	}
+
+// Advance and wrap the phase
+/////////////////////////////
+	t += dt;
+	if (t >= 1.0){
+		t -= 1.0;
+	}
+	osc->phase = t;
+
+	return (float)value;
+}
+
+void osc_process_block(oscillator* osc, float* out, int n){
+	int i;
+	for (i = 0; i < n; i++){
+		out[i] = osc_process(osc);
+	}
+}
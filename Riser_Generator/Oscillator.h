@@ -0,0 +1,63 @@
+// Oscillator Module
+//
+// Fractional phase accumulator with band-limited waveforms. Saw and
+// square use PolyBLEP corrections at their jumps, the triangle uses
+// PolyBLAMP corrections at its corners. They run cheaper per sample
+// than mip-mapped wavetables, which alias far less but need their
+// tables; "make bench" measures both.
+
+#ifndef OSCILLATOR_H
+#define OSCILLATOR_H
+
+typedef enum {
+	OSC_SINE	= 0,
+	OSC_TRI		= 1,
+	OSC_SAW		= 2,
+	OSC_SQUARE	= 3,
+} OSC_WAVEFORMS;
+
+typedef enum {
+	SINE_LIBM		= 0,	// sin() from libm, the reference
+	SINE_TABLE		= 1,	// linearly interpolated lookup table
+	SINE_POLY		= 2,	// odd polynomial after quarter-wave folding
+	SINE_QUADRATURE	= 3,	// rotating phasor, renormalized every sample
+} SINE_MODES;
+
+#define SINE_MODE_COUNT 4
+
+typedef struct _oscillator{
+	double phase;		// position in the cycle, [0, 1)
+	double increment;	// cycles per sample
+	int waveform;
+	int sine_mode;
+	// phasor state for SINE_QUADRATURE
+	double quad_cos;
+	double quad_sin;
+	double rot_cos;
+	double rot_sin;
+}oscillator;
+
+// Builds the tables shared by every oscillator. The first call runs the
+// trig, so make it before the audio thread starts; vp_new does. Later
+// calls, from any thread, return at once.
+void osc_prepare_tables(void);
+
+// Calls osc_prepare_tables, which only costs a check once the tables exist
+void osc_init(oscillator* osc, int waveform,
+				float frequency,
+				int sample_rate);
+
+void osc_set_sine_mode(oscillator* osc, int sine_mode);
+
+const char* osc_sine_mode_name(int sine_mode);
+
+// Changes pitch without resetting the phase
+void osc_set_frequency(oscillator* osc, float frequency, int sample_rate);
+
+// Returns the next sample in [-1, 1]
+float osc_process(oscillator* osc);
+
+// Fills out with n samples
+void osc_process_block(oscillator* osc, float* out, int n);
+
+#endif
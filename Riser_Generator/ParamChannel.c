@@ -0,0 +1,56 @@
+#include "ParamChannel.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PC_DIRTY 4 // set on the middle slot when it holds an unread set
+
+void pc_init(param_channel* pc, const riser_params* initial){
+	int i;
+	for (i = 0; i < 3; i++){
+		pc->slots[i] = *initial;
+	}
+	pc->write_slot = 0;
+	atomic_init(&pc->middle, 1);
+	pc->read_slot = 2;
+	pc->last = *initial;
+	pc->published = 0;
+	pc->merged = 0;
+}
+
+void pc_publish(param_channel* pc, const riser_params* params){
+	int prev;
+
+	if (memcmp(params, &pc->last, sizeof(riser_params)) == 0){
+		return;
+	}
+	pc->last = *params;
+
+// Fill our private slot, then swap it into the middle
+/////////////////////////////////////////////////////
+	pc->slots[pc->write_slot] = *params;
+	prev = atomic_exchange_explicit(&pc->middle, pc->write_slot | PC_DIRTY,
+									memory_order_acq_rel);
+	pc->write_slot = prev & ~PC_DIRTY;
+
+	pc->published++;
+	if (prev & PC_DIRTY){
+		// the consumer never picked the previous set up
+		pc->merged++;
+	}
+}
+
+const riser_params* pc_fetch(param_channel* pc){
+	int prev;
+
+	if (atomic_load_explicit(&pc->middle, memory_order_relaxed) & PC_DIRTY){
+		prev = atomic_exchange_explicit(&pc->middle, pc->read_slot,
+										memory_order_acq_rel);
+		pc->read_slot = prev & ~PC_DIRTY;
+	}
+	return &pc->slots[pc->read_slot];
+}
+
+void pc_print_info(param_channel* pc){
+	printf("Parameter updates published: %u\n", pc->published);
+	printf("Parameter updates merged: %u\n", pc->merged);
+}
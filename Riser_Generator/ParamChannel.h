@@ -0,0 +1,48 @@
+// Parameter Channel Module
+//
+// Hands complete parameter sets from the GUI thread (single producer)
+// to the audio callback (single consumer) through a triple buffer.
+// Neither side ever blocks or sees a half written set.
+
+#ifndef PARAMCHANNEL_H
+#define PARAMCHANNEL_H
+
+#include <stdatomic.h>
+#include "Automation.h"
+
+typedef struct _riser_params{
+	float frequency;
+	int amplitude;
+	int wavetype;
+	int sine_mode;
+	int stack;			// voice stack preset
+	float lowpass_freq;
+	float highpass_freq;
+	int topology;		// BQ_TOPOLOGIES of the voice filters
+	int shape;			// filter shape preset after the voice filters
+	riser_automation automation;	// overrides pitch and cutoffs while running
+}riser_params;
+
+typedef struct _param_channel{
+	riser_params slots[3];
+	atomic_int middle;		// slot between the two sides, plus PC_DIRTY
+	int write_slot;			// owned by the producer
+	int read_slot;			// owned by the consumer
+	riser_params last;		// last set published, producer side
+	unsigned int published;	// updates handed to the channel
+	unsigned int merged;	// updates overwritten before the consumer saw them
+}param_channel;
+
+void pc_init(param_channel* pc, const riser_params* initial);
+
+// Producer: publishes a copy of params. Does nothing if params equal
+// the last published set.
+void pc_publish(param_channel* pc, const riser_params* params);
+
+// Consumer: returns the newest complete parameter set. The pointer stays
+// valid until the next call to pc_fetch.
+const riser_params* pc_fetch(param_channel* pc);
+
+void pc_print_info(param_channel* pc);
+
+#endif
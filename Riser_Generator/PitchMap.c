@@ -0,0 +1,47 @@
+#include "PitchMap.h"
+#include <math.h>
+#include <pthread.h>
+
+// 2^(i / PM_TABLE_SIZE) plus a guard point for the interpolation
+static float exp2_table[PM_TABLE_SIZE + 1];
+static pthread_once_t exp2_table_once = PTHREAD_ONCE_INIT;
+
+static void pm_build_table(void){
+	int i;
+	for (i = 0; i <= PM_TABLE_SIZE; i++){
+		exp2_table[i] = (float)pow(2.0, (double)i / PM_TABLE_SIZE);
+	}
+}
+
+void pm_init(pitch_map* pm, float bottom, float top){
+	pthread_once(&exp2_table_once, pm_build_table);
+	pm->bottom = bottom;
+	pm->octaves = log2f(top / bottom);
+}
+
+float pm_exp2(float x){
+	float octave = floorf(x);
+	float pos = (x - octave) * PM_TABLE_SIZE;
+	int index = (int)pos;
+	float frac;
+
+	// x just below an integer can round up to a whole octave
+	if (index >= PM_TABLE_SIZE){
+		index = PM_TABLE_SIZE - 1;
+	}
+	frac = pos - index;
+	float mantissa = exp2_table[index]
+		+ frac * (exp2_table[index + 1] - exp2_table[index]);
+	return ldexpf(mantissa, (int)octave);
+}
+
+float pm_to_frequency(const pitch_map* pm, float position){
+	return pm->bottom * pm_exp2(position * pm->octaves);
+}
+
+float pm_to_position(const pitch_map* pm, float frequency){
+	if (frequency <= 0.f){
+		return 0.f;
+	}
+	return log2f(frequency / pm->bottom) / pm->octaves;
+}
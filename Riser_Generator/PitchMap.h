@@ -0,0 +1,36 @@
+// Pitch Map Module
+//
+// Exponential mapping from a position in [0, 1] to a frequency, so equal
+// distances on the pad are equal musical intervals. pm_exp2 splits its
+// argument into integer and fractional octaves, looks the fraction up in
+// a table with linear interpolation and scales by the power of two. It
+// costs a few multiplies, cheap enough for the audio thread.
+//
+// With PM_TABLE_SIZE segments the interpolation error is at most
+// (ln 2 / PM_TABLE_SIZE)^2 / 8 = 9.2e-7 relative; with float rounding
+// "make bench" measures about 1.0e-6, or 0.002 cents.
+
+#ifndef PITCHMAP_H
+#define PITCHMAP_H
+
+#define PM_TABLE_SIZE 256
+
+typedef struct _pitch_map{
+	float bottom;	// frequency at position 0
+	float octaves;	// octaves between position 0 and position 1
+}pitch_map;
+
+// Also builds the shared exp2 table the first time any thread calls it,
+// so call it before the audio thread starts.
+void pm_init(pitch_map* pm, float bottom, float top);
+
+// Frequency at position (0 = bottom, 1 = top), fractional Hz
+float pm_to_frequency(const pitch_map* pm, float position);
+
+// Position of frequency, uses log2 from libm, not meant for audio rate
+float pm_to_position(const pitch_map* pm, float frequency);
+
+// 2^x from the table
+float pm_exp2(float x);
+
+#endif
@@ -0,0 +1,241 @@
+#include "RiserEngine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+const voice_stack re_stacks[] = {
+	{ "SINGLE", 1, { 1.f }, { .5f } },
+	{ "DETUNED x3", 3, { .993092f, 1.f, 1.006956f }, { 0.f, .5f, 1.f } },
+	{ "DETUNED x7", 7,
+		{ .988514f, .993092f, .996540f, 1.f, 1.003472f, 1.006956f, 1.011619f },
+		{ 0.f, .8f, .3f, .5f, .7f, .2f, 1.f } },
+	{ "MAJOR CHORD", 4, { 1.f, 1.259921f, 1.498307f, 2.f }, { .3f, .7f, .4f, .6f } },
+	{ "OCTAVES", 3, { .5f, 1.f, 2.f }, { .5f, .2f, .8f } },
+};
+const int re_stack_count = sizeof(re_stacks) / sizeof(re_stacks[0]);
+
+const filter_shape re_shapes[] = {
+	{ "12 DB", 0, {0}, {0}, {0}, {0} },
+	{ "24 DB", 1, { LOWPASS }, { 1.f }, { .7071f }, { 0.f } },
+	{ "48 DB", 3, { LOWPASS, LOWPASS, LOWPASS }, { 1.f, 1.f, 1.f },
+		{ .5412f, .7071f, 1.3066f }, { 0.f, 0.f, 0.f } },
+	{ "FORMANT", 2, { PEAK, PEAK }, { .5f, .25f }, { 4.f, 4.f }, { 9.f, 6.f } },
+	{ "SHELVED", 2, { LOWSHELF, HIGHSHELF }, { .25f, .5f }, { .7071f, .7071f },
+		{ -6.f, 3.f } },
+};
+const int re_shape_count = sizeof(re_shapes) / sizeof(re_shapes[0]);
+
+// riser_engine.shapes holds a graph per preset
+_Static_assert(sizeof(re_shapes) / sizeof(re_shapes[0]) <= RE_MAX_SHAPES,
+				"more filter shapes than RE_MAX_SHAPES");
+
+struct _riser_engine{
+	voice_pool* voices;
+	job_pool* jobs;			// NULL without workers
+	automation automation;
+	param_channel channel;
+	int current_stack;		// stack the pool is playing, -1 before the first render
+	int current_topology;	// filter topology of the pool
+	int current_shape;		// filter shape of the pool
+	filter_graph shapes[RE_MAX_SHAPES];	// re_shapes, designed in re_new
+	int channels;
+	int block_size;
+	int sample_rate;
+};
+
+// Designs the graph of every shape, building their coefficient tables
+// here rather than on the audio thread. Returns 0 if the tables run out.
+static int re_build_shapes(riser_engine* re){
+	int i, s;
+
+	for (i = 0; i < re_shape_count; i++){
+		const filter_shape* shape = &re_shapes[i];
+		filter_graph* fg = &re->shapes[i];
+
+		fg_init(fg, 1, re->sample_rate);
+		for (s = 0; s < shape->count; s++){
+			fg_add_stage(fg, shape->type[s], 1000.f * shape->ratio[s],
+						shape->q[s], shape->db_gain[s]);
+			fg_follow(fg, s, shape->ratio[s]);
+			if (fg->table[s] == NULL){
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+riser_engine* re_new(int voice_count, int channels,
+					int block_size,
+					int sample_rate,
+					int workers,
+					const riser_params* initial){
+
+	riser_engine* tmp = (riser_engine*)malloc(sizeof(riser_engine));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for riser engine");
+		return tmp;
+	}
+
+	tmp->voices = vp_new(voice_count, channels, block_size, sample_rate, RE_FILTER_Q);
+	if (tmp->voices == NULL){
+		free(tmp);
+		return NULL;
+	}
+
+	tmp->jobs = NULL;
+	if (workers > 0){
+		tmp->jobs = jp_new(workers, true);
+		if (tmp->jobs == NULL){
+			vp_destroy(tmp->voices);
+			free(tmp);
+			return NULL;
+		}
+	}
+
+	tmp->current_stack = -1;
+	tmp->current_topology = BQ_DF1;
+	tmp->current_shape = 0;		// the pool starts without stages
+	tmp->channels = channels;
+	tmp->block_size = block_size;
+	tmp->sample_rate = sample_rate;
+	if (!re_build_shapes(tmp)){
+		jp_destroy(tmp->jobs);
+		vp_destroy(tmp->voices);
+		free(tmp);
+		return NULL;
+	}
+	au_init(&tmp->automation, sample_rate);
+	pc_init(&tmp->channel, initial);
+
+	return tmp;
+}
+
+void re_set_params(riser_engine* re, const riser_params* params){
+	pc_publish(&re->channel, params);
+}
+
+void re_render(riser_engine* re, float* out, int frames){
+	// one consistent parameter set for the whole block
+	re_render_params(re, pc_fetch(&re->channel), out, frames);
+}
+
+float re_clamp_cutoff(riser_engine* re, float frequency){
+	if (frequency < RE_MIN_CUTOFF){
+		return RE_MIN_CUTOFF;
+	}
+	if (frequency > re->sample_rate * 0.45){
+		return re->sample_rate * 0.45;
+	}
+	return frequency;
+}
+
+// Keeps a preset number from the host inside a table of count entries
+static int re_clamp_index(int index, int count){
+	if (index < 0){
+		return 0;
+	}
+	if (index >= count){
+		return count - 1;
+	}
+	return index;
+}
+
+// Fades out the voices playing and starts the ones of re_stacks[number],
+// the pool steals voices if it is too small for both
+static void re_play_stack(riser_engine* re, const riser_params* params,
+					int number){
+	const voice_stack* stack = &re_stacks[number];
+	float gain = 1. / sqrt(stack->count);	// keep the loudness of a single voice
+	int i;
+
+	vp_release_all(re->voices);
+	for (i = 0; i < stack->count; i++){
+		vp_note_on(re->voices, stack->ratio[i], stack->pan[i], gain,
+					params->wavetype, params->sine_mode);
+	}
+	re->current_stack = number;
+}
+
+void re_render_params(riser_engine* re, const riser_params* params,
+					float* out, int frames){
+	automation* au = &re->automation;
+	int stack = re_clamp_index(params->stack, re_stack_count);
+	int shape = re_clamp_index(params->shape, re_shape_count);
+	int done, n;
+
+	// start or stop the rise the control thread asked for
+	au_update(au, &params->automation);
+
+	if (params->topology != re->current_topology){
+		vp_set_topology(re->voices, params->topology);
+		re->current_topology = params->topology;
+	}
+
+	if (shape != re->current_shape){
+		vp_set_shape(re->voices, &re->shapes[shape]);
+		re->current_shape = shape;
+	}
+
+	// pitch and cutoffs from the rise, updated every AU_STEP samples
+	if (au->active){
+		for (done = 0; done < frames; done += n){
+			n = (frames - done < AU_STEP) ? frames - done : AU_STEP;
+			au_advance(au, n);
+
+			vp_set_cutoffs(re->voices, re_clamp_cutoff(re, au->cutoff),
+						re_clamp_cutoff(re, (au->cutoff - RE_HIGHPASS_OFFSET) * 1.2), n);
+
+			// voices of a new stack start at the first step's cutoffs
+			if (done == 0){
+				if (stack != re->current_stack){
+					re_play_stack(re, params, stack);
+				}
+				vp_set_waveform(re->voices, params->wavetype, params->sine_mode);
+			}
+			vp_render(re->voices, re->jobs, au->pitch, params->amplitude,
+						out + done * re->channels, n);
+		}
+		return;
+	}
+
+	// retune the filters, gliding over this block
+	vp_set_cutoffs(re->voices, re_clamp_cutoff(re, params->lowpass_freq),
+				re_clamp_cutoff(re, params->highpass_freq * 1.2), frames);
+
+	// a newly picked stack starts at the new cutoffs
+	if (stack != re->current_stack){
+		re_play_stack(re, params, stack);
+	}
+
+	// the phases carry over from the last block
+	vp_set_waveform(re->voices, params->wavetype, params->sine_mode);
+	vp_render(re->voices, re->jobs, params->frequency, params->amplitude, out, frames);
+}
+
+float re_shown_pitch(riser_engine* re){
+	return au_shown_pitch(&re->automation);
+}
+
+float re_shown_cutoff(riser_engine* re){
+	return au_shown_cutoff(&re->automation);
+}
+
+int re_shown_serial(riser_engine* re){
+	return au_shown_serial(&re->automation);
+}
+
+void re_print_info(riser_engine* re){
+	// parameter sets that never reached the audio thread
+	pc_print_info(&re->channel);
+}
+
+void re_destroy(riser_engine* re){
+	if (re == NULL){
+		return;
+	}
+	jp_destroy(re->jobs);
+	vp_destroy(re->voices);
+	free(re);
+}
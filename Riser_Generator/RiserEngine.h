@@ -0,0 +1,90 @@
+// Riser Engine Module
+//
+// The synthesis core of the riser generator behind one handle, without
+// any audio device, window or global state: a voice pool with its
+// filters, the riser automation and the channel the parameters cross
+// over on. A host creates an engine, publishes parameter sets from its
+// control thread with re_set_params and calls re_render from its audio
+// thread. Everything is allocated in re_new, rendering never allocates
+// or blocks.
+
+#ifndef RISERENGINE_H
+#define RISERENGINE_H
+
+#include "ParamChannel.h"
+#include "VoicePool.h"
+#include "JobPool.h"
+#include "Automation.h"
+
+#define RE_MAX_STACK 8		// voices in the largest stack
+#define RE_FILTER_Q 10.0
+#define RE_MIN_CUTOFF 10	// lowest cutoff handed to the filters, keeps them stable
+
+// highpass below the lowpass while a rise runs, as the pad places it
+#define RE_HIGHPASS_OFFSET 220.f
+
+// voices played together, selected by riser_params.stack
+typedef struct _voice_stack{
+	const char* name;
+	int count;
+	float ratio[RE_MAX_STACK];	// pitch relative to the riser frequency
+	float pan[RE_MAX_STACK];	// 0 is the first channel, 1 the last
+}voice_stack;
+
+extern const voice_stack re_stacks[];
+extern const int re_stack_count;
+
+#define RE_MAX_SHAPES 8
+
+// stages after every voice's lowpass/highpass, selected by
+// riser_params.shape, each following the lowpass cutoff at a ratio
+typedef struct _filter_shape{
+	const char* name;
+	int count;
+	int type[FG_MAX_STAGES];		// FILTER_TYPES
+	float ratio[FG_MAX_STAGES];		// of the lowpass cutoff
+	float q[FG_MAX_STAGES];
+	float db_gain[FG_MAX_STAGES];
+}filter_shape;
+
+extern const filter_shape re_shapes[];
+extern const int re_shape_count;
+
+// Opaque handle, everything a host needs goes through the functions below
+typedef struct _riser_engine riser_engine;
+
+// Renders blocks of at most block_size frames with channels interleaved
+// channels. workers > 0 starts pinned helper threads for large voice
+// counts. initial is played until the first re_set_params. Returns NULL
+// if memory or the threads can't be had.
+riser_engine* re_new(int voice_count, int channels,
+					int block_size,
+					int sample_rate,
+					int workers,
+					const riser_params* initial);
+
+// Control thread: hands a copy of params to the audio thread. A stack
+// or shape outside re_stacks or re_shapes plays the nearest entry.
+void re_set_params(riser_engine* re, const riser_params* params);
+
+// Audio thread: renders frames with the newest parameter set
+void re_render(riser_engine* re, float* out, int frames);
+
+// Renders frames with params, bypassing the channel. For hosts that
+// control and render on one thread, such as offline renders.
+void re_render_params(riser_engine* re, const riser_params* params,
+					float* out, int frames);
+
+// Keeps a cutoff inside the range the biquads are stable in
+float re_clamp_cutoff(riser_engine* re, float frequency);
+
+// Pitch and cutoff of the running rise as last rendered, for the GUI
+float re_shown_pitch(riser_engine* re);
+float re_shown_cutoff(riser_engine* re);
+int re_shown_serial(riser_engine* re);
+
+void re_print_info(riser_engine* re);
+
+void re_destroy(riser_engine* re);
+
+#endif
@@ -0,0 +1,326 @@
+#include "VoicePool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI (3.141592654)
+#endif
+
+voice_pool* vp_new(int voice_count, int channels,
+					int block_size,
+					int sample_rate,
+					float q){
+
+	voice_pool* tmp = (voice_pool*)malloc(sizeof(voice_pool));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for voice pool");
+		return tmp;
+	}
+
+	if (voice_count > VP_MAX_VOICES){
+		voice_count = VP_MAX_VOICES;
+	}
+
+	// shared by every pool, built here rather than on the audio thread
+	osc_prepare_tables();
+	tmp->low_table = ct_get(LOWPASS, 0.f);
+	tmp->high_table = ct_get(HIGHPASS, 0.f);
+	if (tmp->low_table == NULL || tmp->high_table == NULL){
+		free(tmp);
+		return NULL;
+	}
+
+	tmp->scratch = (float*)calloc(voice_count * block_size, sizeof(float));
+	if (tmp->scratch == NULL){
+		printf("Error while allocating memory for voice pool");
+		free(tmp);
+		return NULL;
+	}
+
+	tmp->voice_count = voice_count;
+	tmp->channels = channels;
+	tmp->block_size = block_size;
+	tmp->sample_rate = sample_rate;
+	tmp->q = q;
+	tmp->active_count = 0;
+	tmp->next_age = 0;
+	tmp->stolen = 0;
+	memset(tmp->state, 0, sizeof(tmp->state));
+
+	// the templates only hold coefficients, they never process audio
+	tmp->lowpass_freq = sample_rate * 0.45f;
+	tmp->highpass_freq = 10.f;
+	bq_init(&tmp->low_template, LOWPASS, tmp->lowpass_freq, q, 1.0, sample_rate);
+	bq_init(&tmp->high_template, HIGHPASS, tmp->highpass_freq, q, 1.0, sample_rate);
+	fg_init(&tmp->shape_template, 1, sample_rate);
+
+	return tmp;
+}
+
+// Starts the note on voice v from silence with fresh oscillator and filters
+static void vp_start_voice(voice_pool* vp, int v, float ratio, float pan,
+				float gain, int waveform, int sine_mode){
+	float position;
+
+	vp->state[v] = VOICE_ON;
+	vp->ratio[v] = ratio;
+	vp->level[v] = 0.f;
+	vp->target_level[v] = gain;
+	vp->fade_step[v] = gain / vp->block_size;
+	vp->fade_left[v] = vp->block_size;
+
+	osc_init(&vp->osc[v], waveform, 0.f, vp->sample_rate);
+	// spread the start phases so stacked voices don't line up
+	vp->osc[v].phase = fmod(v * 0.618034, 1.0);
+	osc_set_sine_mode(&vp->osc[v], sine_mode);
+
+	// fresh filter history with the current shared coefficients
+	vp->low[v] = vp->low_template;
+	vp->high[v] = vp->high_template;
+	vp->shape[v] = vp->shape_template;
+
+// Equal power pan between two neighbouring channels
+////////////////////////////////////////////////////
+	position = pan * (vp->channels - 1);
+	if (position < 0.f){
+		position = 0.f;
+	}
+	vp->pan_channel[v] = (int)position;
+	if (vp->pan_channel[v] >= vp->channels - 1){
+		vp->pan_channel[v] = (vp->channels > 1) ? vp->channels - 2 : 0;
+	}
+	position -= vp->pan_channel[v];
+	if (vp->channels == 1){
+		vp->pan_gain[v][0] = 1.f;
+		vp->pan_gain[v][1] = 0.f;
+	}
+	else{
+		vp->pan_gain[v][0] = cos(position * M_PI / 2);
+		vp->pan_gain[v][1] = sin(position * M_PI / 2);
+	}
+}
+
+int vp_note_on(voice_pool* vp, float ratio, float pan, float gain,
+				int waveform, int sine_mode){
+	int v, i, oldest = -1;
+
+// Take a free voice, or steal the one started first
+////////////////////////////////////////////////////
+	for (v = 0; v < vp->voice_count; v++){
+		if (vp->state[v] == VOICE_FREE){
+			break;
+		}
+	}
+	if (v < vp->voice_count){
+		vp->active[vp->active_count++] = v;
+		vp->age[v] = vp->next_age++;
+		vp_start_voice(vp, v, ratio, pan, gain, waveform, sine_mode);
+		return v;
+	}
+
+	for (i = 0; i < vp->active_count; i++){
+		if (oldest < 0 || vp->age[vp->active[i]] < vp->age[oldest]){
+			oldest = vp->active[i];
+		}
+	}
+	v = oldest;
+	vp->stolen++;
+	vp->age[v] = vp->next_age++;
+
+	// fade out from where it is, vp_render starts the note when silent.
+	// A voice already fading keeps its fade, a stolen one just gets a
+	// newer pending note.
+	if (vp->state[v] == VOICE_ON){
+		vp->target_level[v] = 0.f;
+		vp->fade_step[v] = -vp->level[v] / vp->block_size;
+		vp->fade_left[v] = vp->block_size;
+	}
+	vp->state[v] = VOICE_STOLEN;
+	vp->pending_ratio[v] = ratio;
+	vp->pending_pan[v] = pan;
+	vp->pending_gain[v] = gain;
+	vp->pending_waveform[v] = waveform;
+	vp->pending_sine_mode[v] = sine_mode;
+
+	return v;
+}
+
+void vp_note_off(voice_pool* vp, int voice){
+	// the note a stolen voice waits to start never sounds
+	if (vp->state[voice] == VOICE_STOLEN){
+		vp->state[voice] = VOICE_RELEASING;
+	}
+	if (vp->state[voice] == VOICE_ON){
+		vp->state[voice] = VOICE_RELEASING;
+		vp->target_level[voice] = 0.f;
+		vp->fade_step[voice] = -vp->level[voice] / vp->block_size;
+		vp->fade_left[voice] = vp->block_size;
+	}
+}
+
+void vp_release_all(voice_pool* vp){
+	int i;
+	for (i = 0; i < vp->active_count; i++){
+		vp_note_off(vp, vp->active[i]);
+	}
+}
+
+void vp_set_waveform(voice_pool* vp, int waveform, int sine_mode){
+	int i;
+	for (i = 0; i < vp->active_count; i++){
+		oscillator* osc = &vp->osc[vp->active[i]];
+		osc->waveform = waveform;
+		if (osc->sine_mode != sine_mode){
+			osc_set_sine_mode(osc, sine_mode);
+		}
+	}
+}
+
+void vp_set_topology(voice_pool* vp, int topology){
+	int i;
+
+	bq_set_topology(&vp->low_template, topology);
+	bq_set_topology(&vp->high_template, topology);
+	for (i = 0; i < vp->active_count; i++){
+		bq_set_topology(&vp->low[vp->active[i]], topology);
+		bq_set_topology(&vp->high[vp->active[i]], topology);
+	}
+}
+
+void vp_set_shape(voice_pool* vp, const filter_graph* shape){
+	int i;
+
+	vp->shape_template = *shape;
+	fg_set_base(&vp->shape_template, vp->lowpass_freq, 0);
+	for (i = 0; i < vp->active_count; i++){
+		fg_glide_to(&vp->shape[vp->active[i]], &vp->shape_template, 0);
+	}
+}
+
+void vp_set_cutoffs(voice_pool* vp, float lowpass_freq, float highpass_freq,
+					int ramp_length){
+	int i;
+
+	if (lowpass_freq != vp->lowpass_freq){
+		ct_set_target(vp->low_table, &vp->low_template, lowpass_freq, vp->q,
+						vp->sample_rate, 0);
+		for (i = 0; i < vp->active_count; i++){
+			bq_glide_to(&vp->low[vp->active[i]], &vp->low_template, ramp_length);
+		}
+		if (vp->shape_template.stages > 0){
+			fg_set_base(&vp->shape_template, lowpass_freq, 0);
+			for (i = 0; i < vp->active_count; i++){
+				fg_glide_to(&vp->shape[vp->active[i]], &vp->shape_template, ramp_length);
+			}
+		}
+		vp->lowpass_freq = lowpass_freq;
+	}
+	if (highpass_freq != vp->highpass_freq){
+		ct_set_target(vp->high_table, &vp->high_template, highpass_freq, vp->q,
+						vp->sample_rate, 0);
+		for (i = 0; i < vp->active_count; i++){
+			bq_glide_to(&vp->high[vp->active[i]], &vp->high_template, ramp_length);
+		}
+		vp->highpass_freq = highpass_freq;
+	}
+}
+
+// Job for one sounding voice: oscillator and filters into its scratch block
+static void vp_render_voice(void* context, int job){
+	voice_pool* vp = (voice_pool*)context;
+	int v = vp->active[job];
+	float* scratch = vp->scratch + v * vp->block_size;
+	// audio thread or worker, a decaying filter tail must not go denormal.
+	// The thread may belong to the host, so its own mode is put back.
+	int previous = bq_flush_denormals(1);
+
+	osc_set_frequency(&vp->osc[v], vp->render_frequency * vp->ratio[v], vp->sample_rate);
+	osc_process_block(&vp->osc[v], scratch, vp->render_frames);
+	bq_process_cascade(&vp->low[v], &vp->high[v], scratch, scratch, vp->render_frames);
+	if (vp->shape[v].stages > 0){
+		fg_process(&vp->shape[v], scratch, scratch, vp->render_frames);
+	}
+
+	bq_flush_denormals(previous);
+}
+
+void vp_render(voice_pool* vp, job_pool* jobs,
+				float frequency, float amplitude,
+				float* out, int frames){
+	int channels = vp->channels;
+	int i, k;
+
+	vp->render_frequency = frequency;
+	vp->render_frames = frames;
+
+	if (jobs != NULL && vp->active_count > 1
+			&& vp->active_count * frames >= VP_PARALLEL_MIN_WORK){
+		jp_run(jobs, vp_render_voice, vp, vp->active_count);
+	}
+	else{
+		for (i = 0; i < vp->active_count; i++){
+			vp_render_voice(vp, i);
+		}
+	}
+
+	memset(out, 0, frames * channels * sizeof(float));
+
+	for (i = 0; i < vp->active_count; i++){
+		int v = vp->active[i];
+		float* scratch = vp->scratch + v * vp->block_size;
+		int c0 = vp->pan_channel[v];
+		int c1 = (channels > 1) ? c0 + 1 : c0;
+		int fade = (vp->fade_left[v] < frames) ? vp->fade_left[v] : frames;
+		float level = vp->level[v] * amplitude;
+		float step = vp->fade_step[v] * amplitude;
+		float g0 = vp->pan_gain[v][0];
+		float g1 = vp->pan_gain[v][1];
+
+// Fade towards the target level and mix into the voice's channels
+//////////////////////////////////////////////////////////////////
+		for (k = 0; k < fade; k++){
+			float sample = scratch[k] * level;
+			out[k * channels + c0] += sample * g0;
+			out[k * channels + c1] += sample * g1;
+			level += step;
+		}
+		vp->fade_left[v] -= fade;
+		vp->level[v] = (vp->fade_left[v] == 0)
+			? vp->target_level[v] : vp->level[v] + vp->fade_step[v] * fade;
+		level = vp->level[v] * amplitude;
+		for (; k < frames; k++){
+			float sample = scratch[k] * level;
+			out[k * channels + c0] += sample * g0;
+			out[k * channels + c1] += sample * g1;
+		}
+	}
+
+// Drop voices that finished fading out, start the notes of stolen ones
+////////////////////////////////////////////////////////////////////////
+	for (i = 0; i < vp->active_count; ){
+		int v = vp->active[i];
+		if (vp->state[v] == VOICE_STOLEN && vp->fade_left[v] == 0){
+			vp_start_voice(vp, v, vp->pending_ratio[v], vp->pending_pan[v],
+							vp->pending_gain[v], vp->pending_waveform[v],
+							vp->pending_sine_mode[v]);
+		}
+		if (vp->state[v] == VOICE_RELEASING && vp->fade_left[v] == 0){
+			vp->state[v] = VOICE_FREE;
+			vp->active[i] = vp->active[--vp->active_count];
+		}
+		else{
+			i++;
+		}
+	}
+}
+
+void vp_destroy(voice_pool* vp){
+	if (vp == NULL){
+		return;
+	}
+	free(vp->scratch);
+	free(vp);
+}
@@ -0,0 +1,131 @@
+// Voice Pool Module
+//
+// Fixed pool of voices, each with its own oscillator and lowpass/highpass
+// chain, optionally followed by a filter graph shaping the slope or
+// timbre. The lowpass and highpass stay biquads rather than the graph's
+// first stages because they run in any of the BQ_TOPOLOGIES, where the
+// graph only runs direct form I; an empty graph costs nothing. All
+// memory is allocated in vp_new; starting, stealing and rendering voices
+// never allocates. Per-voice fields are kept in separate arrays so the
+// render loop walks contiguous memory.
+
+#ifndef VOICEPOOL_H
+#define VOICEPOOL_H
+
+#include "Biquad.h"
+#include "CoefTable.h"
+#include "FilterGraph.h"
+#include "Oscillator.h"
+#include "JobPool.h"
+
+#define VP_MAX_VOICES 64
+
+// voices x frames below which vp_render stays on the calling thread,
+// handing out the jobs would cost more than it saves
+#define VP_PARALLEL_MIN_WORK 4096
+
+typedef enum {
+	VOICE_FREE		= 0,
+	VOICE_ON		= 1,
+	VOICE_RELEASING	= 2,
+	VOICE_STOLEN	= 3,	// fading out, then starts its pending note
+} VOICE_STATES;
+
+typedef struct _voice_pool{
+	// per voice, indexed by voice number
+	oscillator osc[VP_MAX_VOICES];
+	biquad low[VP_MAX_VOICES];
+	biquad high[VP_MAX_VOICES];
+	filter_graph shape[VP_MAX_VOICES];	// after low and high, often empty
+	float ratio[VP_MAX_VOICES];			// pitch relative to the riser frequency
+	float level[VP_MAX_VOICES];			// gain reached at the end of the last render
+	float target_level[VP_MAX_VOICES];	// gain the voice fades to
+	float fade_step[VP_MAX_VOICES];		// gain change per sample while fading
+	int fade_left[VP_MAX_VOICES];		// samples until target_level is reached
+	float pan_gain[VP_MAX_VOICES][2];	// gains into pan_channel and the one after
+	int pan_channel[VP_MAX_VOICES];
+	int state[VP_MAX_VOICES];
+	unsigned int age[VP_MAX_VOICES];	// note-on order, the oldest gets stolen
+	// note a VOICE_STOLEN voice starts once it is silent
+	float pending_ratio[VP_MAX_VOICES];
+	float pending_pan[VP_MAX_VOICES];
+	float pending_gain[VP_MAX_VOICES];
+	int pending_waveform[VP_MAX_VOICES];
+	int pending_sine_mode[VP_MAX_VOICES];
+
+	// sounding voices, in no particular order
+	int active[VP_MAX_VOICES];
+	int active_count;
+
+	int voice_count;		// size of the pool
+	int channels;
+	int block_size;
+	int sample_rate;
+	unsigned int next_age;
+	unsigned int stolen;	// voices taken over by vp_note_on
+
+	// shared filter coefficients, looked up once per cutoff change
+	biquad low_template;
+	biquad high_template;
+	const coef_table* low_table;
+	const coef_table* high_table;
+	filter_graph shape_template;		// follows lowpass_freq
+	float lowpass_freq;
+	float highpass_freq;
+	float q;
+
+	// block being rendered, read by the voice jobs
+	float render_frequency;
+	int render_frames;
+
+	float* scratch;			// one block per voice
+}voice_pool;
+
+voice_pool* vp_new(int voice_count, int channels,
+					int block_size,
+					int sample_rate,
+					float q);
+
+// Starts a voice at ratio times the riser frequency, pan between 0
+// (first channel) and 1 (last channel). Steals the oldest voice when
+// the pool is full: it fades out over block_size samples first and the
+// note starts after that, so the steal does not click. Returns the
+// voice number.
+int vp_note_on(voice_pool* vp, float ratio, float pan, float gain,
+				int waveform, int sine_mode);
+
+// Fades the voice out over block_size samples and frees it
+void vp_note_off(voice_pool* vp, int voice);
+
+void vp_release_all(voice_pool* vp);
+
+void vp_set_waveform(voice_pool* vp, int waveform, int sine_mode);
+
+// Runs every voice's filters in topology (BQ_TOPOLOGIES), sounding voices
+// restart their filter history
+void vp_set_topology(voice_pool* vp, int topology);
+
+// Runs shape after every voice's lowpass/highpass, its following stages
+// at their ratio of the lowpass cutoff. The stages run in direct form I
+// whatever the topology. Sounding voices keep the history of stages
+// that keep their type.
+void vp_set_shape(voice_pool* vp, const filter_graph* shape);
+
+// Retunes every voice's filters, gliding over ramp_length samples.
+// Does nothing if the cutoffs did not change.
+void vp_set_cutoffs(voice_pool* vp, float lowpass_freq, float highpass_freq,
+					int ramp_length);
+
+// Renders frames (at most block_size) of every sounding voice, mixed
+// into interleaved out with vp->channels channels. With a job pool the
+// voices are rendered in parallel once there is enough work to split.
+// Blocks may be split into shorter renders, fades always take
+// block_size samples. Denormals are flushed while a voice renders, the
+// calling thread's floating point mode is restored afterwards.
+void vp_render(voice_pool* vp, job_pool* jobs,
+				float frequency, float amplitude,
+				float* out, int frames);
+
+void vp_destroy(voice_pool* vp);
+
+#endif
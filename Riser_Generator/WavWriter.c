@@ -0,0 +1,152 @@
+#include "WavWriter.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define WAVE_FORMAT_PCM 		1
+#define WAVE_FORMAT_IEEE_FLOAT	3
+#define WAV_CHUNK_SIZE			512 // frames converted per fwrite
+
+static void put_u16(unsigned char* p, unsigned int v){
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+static void put_u32(unsigned char* p, unsigned long v){
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+static int bytes_per_sample(int format){
+	return (format == WAV_PCM24) ? 3 : 4;
+}
+
+// Writes the RIFF header for the frames written so far. Float files
+// carry the fact chunk non-PCM formats require.
+static int wav_write_header(wav_writer* wav){
+	unsigned char header[58];
+	int is_float = (wav->format == WAV_FLOAT32);
+	int fmt_size = is_float ? 18 : 16;
+	int block_align = wav->channels * bytes_per_sample(wav->format);
+	unsigned long data_size = wav->frames * block_align;
+	int header_size = 12 + 8 + fmt_size + (is_float ? 12 : 0) + 8;
+	unsigned char* p = header;
+
+	memcpy(p, "RIFF", 4);
+	put_u32(p + 4, header_size - 8 + data_size);
+	memcpy(p + 8, "WAVE", 4);
+	p += 12;
+
+	memcpy(p, "fmt ", 4);
+	put_u32(p + 4, fmt_size);
+	put_u16(p + 8, is_float ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+	put_u16(p + 10, wav->channels);
+	put_u32(p + 12, wav->sample_rate);
+	put_u32(p + 16, (unsigned long)wav->sample_rate * block_align);
+	put_u16(p + 20, block_align);
+	put_u16(p + 22, bytes_per_sample(wav->format) * 8);
+	p += 24;
+	if (is_float){
+		put_u16(p, 0);	// cbSize
+		p += 2;
+
+		memcpy(p, "fact", 4);
+		put_u32(p + 4, 4);
+		put_u32(p + 8, wav->frames);
+		p += 12;
+	}
+
+	memcpy(p, "data", 4);
+	put_u32(p + 4, data_size);
+
+	return fwrite(header, 1, header_size, wav->file) == (size_t)header_size;
+}
+
+wav_writer* wav_open(const char* path, int format,
+					int channels,
+					int sample_rate){
+
+	wav_writer* tmp = (wav_writer*)malloc(sizeof(wav_writer));
+
+	if (tmp == NULL){
+		printf("Error while allocating memory for wav writer");
+		return tmp;
+	}
+
+	tmp->file = fopen(path, "wb");
+	if (tmp->file == NULL){
+		printf("Error while opening %s for writing\n", path);
+		free(tmp);
+		return NULL;
+	}
+	tmp->format = format;
+	tmp->channels = channels;
+	tmp->sample_rate = sample_rate;
+	tmp->frames = 0;
+
+	// placeholder, the sizes are patched in wav_close
+	if (format != RAW_FLOAT32 && !wav_write_header(tmp)){
+		printf("Error while writing to %s\n", path);
+		fclose(tmp->file);
+		free(tmp);
+		return NULL;
+	}
+
+	return tmp;
+}
+
+int wav_write(wav_writer* wav, const float* samples, unsigned long frames){
+	unsigned char chunk[WAV_CHUNK_SIZE * 3];
+	unsigned long count = frames * wav->channels;
+	unsigned long i, n;
+
+	wav->frames += frames;
+
+	if (wav->format != WAV_PCM24){
+		// the float formats are written as they are (little-endian hosts)
+		return fwrite(samples, sizeof(float), count, wav->file) == count;
+	}
+
+// Convert to 24-bit in chunks
+/////////////////////////////
+	for (i = 0; i < count; i += n){
+		unsigned long k;
+		n = (count - i < WAV_CHUNK_SIZE) ? count - i : WAV_CHUNK_SIZE;
+		for (k = 0; k < n; k++){
+			float x = samples[i + k];
+			long v;
+			if (x > 1.0f){
+				x = 1.0f;
+			}
+			if (x < -1.0f){
+				x = -1.0f;
+			}
+			v = (long)(x * 8388607.0f);
+			chunk[3 * k] = v & 0xff;
+			chunk[3 * k + 1] = (v >> 8) & 0xff;
+			chunk[3 * k + 2] = (v >> 16) & 0xff;
+		}
+		if (fwrite(chunk, 3, n, wav->file) != n){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int wav_close(wav_writer* wav){
+	int ok = 1;
+
+	if (wav == NULL){
+		return 0;
+	}
+	if (wav->format != RAW_FLOAT32){
+		ok = fseek(wav->file, 0, SEEK_SET) == 0 && wav_write_header(wav);
+	}
+	// buffered samples only reach the disk here
+	if (fclose(wav->file) != 0){
+		ok = 0;
+	}
+	free(wav);
+	return ok;
+}
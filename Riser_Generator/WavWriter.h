@@ -0,0 +1,37 @@
+// Wav Writer Module
+//
+// Streams interleaved float audio into a WAV file (32-bit float or
+// 24-bit PCM) or into a headerless raw float file.
+
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <stdio.h>
+
+typedef enum {
+	WAV_FLOAT32	= 0,
+	WAV_PCM24	= 1,
+	RAW_FLOAT32	= 2,
+} WAV_FORMATS;
+
+typedef struct _wav_writer{
+	FILE* file;
+	int format;
+	int channels;
+	int sample_rate;
+	unsigned long frames;	// frames written so far
+}wav_writer;
+
+// Returns NULL if the file can't be created
+wav_writer* wav_open(const char* path, int format,
+					int channels,
+					int sample_rate);
+
+// Writes frames of interleaved samples, returns 0 on a write error
+int wav_write(wav_writer* wav, const float* samples, unsigned long frames);
+
+// Patches the header sizes and closes the file. Returns 0 if that or
+// flushing the last samples failed, the file is then incomplete.
+int wav_close(wav_writer* wav);
+
+#endif
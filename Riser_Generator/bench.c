@@ -0,0 +1,1721 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench.c
+ *
+ *    Description:  Standalone DSP benchmark for the riser generator. Runs without
+ *                  PortAudio or OpenGL, build it with "make bench". With --json the
+ *                  tables go to stderr and every measurement is written to stdout
+ *                  as JSON ("make bench-json" keeps it in bench.json).
+ *
+ * =====================================================================================
+ */
+
+//-----------------------------------------------------------------------------
+// #INCLUDES
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+#include "Oscillator.h"
+#include "Biquad.h"
+#include "VoicePool.h"
+#include "FFT.h"
+#include "PitchMap.h"
+#include "Automation.h"
+#include "WavWriter.h"
+#include "RiserEngine.h"
+#include "CoefTable.h"
+#include "FilterGraph.h"
+
+//-----------------------------------------------------------------------------
+// #DEFINES
+//-----------------------------------------------------------------------------
+#define SAMPLE_RATE             44100
+#define BENCH_SAMPLES           (1 << 22) //samples per timed run
+#define THD_SAMPLES             65536 //length of the THD analysis
+#define THD_CYCLES              661 //whole cycles in THD_SAMPLES, ~445 Hz
+#define PI                      3.14159265358979323846
+#define BLOCK_SIZE              1024 //frames per block, as in the callback
+#define MAX_CHANNELS            8
+#define FFT_FRAMES              2000 //analyser frames per timed run
+#define SETUP_CALLS             200000 //calls per timed coefficient run
+#define TABLE_DESIGNS           4000 //random designs in the table accuracy report
+#define TABLE_POINTS            64 //frequencies each design's response is compared at
+#define TABLE_GAIN              6.f //dB, for the types that use it
+#define TABLE_MIN_Q             0.5 //Q range of the random designs
+#define TABLE_MAX_Q             20.
+#define TABLE_SPLIT             200.f //Hz, below it float coefficients lose most
+#define TABLE_MARGIN            6. //dB the table may be worse than the float formulas
+#define RENDER_SAMPLES          (1 << 20) //frames per timed render run
+#define RENDER_VOICES           7 //voices in the render benchmark
+#define RENDER_STACK            2 //DETUNED x7 in re_stacks
+#define MAX_RESULTS             256
+#define TOPOLOGY_SAMPLES        (1 << 18) //samples compared against the reference
+#define TOPOLOGY_Q              10.0 //Q of the voice filters
+#define DENORMAL_SAMPLES        (1 << 20) //samples of a decaying tail
+#define GRAPH_CHANNELS          2 //channels of the filter graph benchmark
+#define GRAPH_BASE              2000.f //Hz, base frequency the stages follow
+#define GRAPH_STEP              300 //frames per retune in the graph check, not a block multiple
+#define GRAPH_TOLERANCE         1e-4 //accepted difference from chained bq_process
+
+//golden-output checks
+#define GOLDEN_DIR              "golden" //reference renders, relative to the bench
+#define GOLDEN_FRAMES           8192 //frames per golden render
+#define GOLDEN_BLOCK            256 //frames per vp_render call in the checks
+//dB, lowest accepted SNR against a reference. The resonant filters turn
+//rounding differences into larger output differences, contracting to FMA
+//alone moves the filtered cases to about 57 dB
+#define GOLDEN_SNR_OSC          90.
+#define GOLDEN_SNR_FILTER       50.
+#define GOLDEN_SWEEP            4 //cases after the four waveforms
+#define GOLDEN_RISER            5
+#define GOLDEN_SHAPE            2 //re_shapes entry the riser case switches to
+#define GOLDEN_COUNT            6
+#define ALIAS_SIZE              65536 //samples in the aliasing analysis
+#define ALIAS_CYCLES            2917 //prime, so no alias lands on a harmonic, ~1963 Hz
+//dB, highest accepted aliasing floor, about 3 dB above the PolyBLEP
+//oscillators; a naive saw reads about -12 dB here
+#define ALIAS_LIMIT_SINE        -110.
+#define ALIAS_LIMIT_TRI         -50.
+#define ALIAS_LIMIT_SAW         -26.
+#define ALIAS_LIMIT_SQUARE      -29.
+#define WAVETABLE_SIZE          2048 //samples per cycle of each mip level
+#define WAVETABLE_LEVELS        11 //level k holds 2^k harmonics, the last fills the table
+#define BUTTERWORTH_Q           0.70710678f //-3 dB at the cutoff
+#define TONE_SETTLE             8192 //frames before a tone is measured
+#define TONE_FRAMES             8192 //frames the tone level is fitted over
+#define CUTOFF_TOLERANCE        .01 //accepted -3 dB point error, relative
+
+#ifndef BENCH_CFLAGS
+#define BENCH_CFLAGS            "unknown"
+#endif
+
+//-----------------------------------------------------------------------------
+// Name: GLOBAL VARIABLES
+//-----------------------------------------------------------------------------
+
+//one measurement, per sample or per call
+typedef struct {
+    const char *group;
+    char name[40];
+    const char *unit; //"sample" or "call"
+    int block;
+    int channels;
+    double ns;
+} bench_result;
+
+bench_result g_results[MAX_RESULTS];
+int g_result_count = 0;
+
+//the tables, stdout or stderr with --json
+FILE *g_text;
+
+//a fixed render compared against its reference in GOLDEN_DIR
+typedef struct {
+    const char *name;
+    int channels;
+    int voices; //0 for the bare oscillator cases
+    double min_snr;
+} golden_case;
+
+//--filter names of the BQ_TOPOLOGIES
+const char *g_topology_names[BQ_TOPOLOGY_COUNT] = { "df1", "tdf2", "double", "svf" };
+
+//FILTER_TYPES as printed by the benchmarks
+const char *g_type_names[HIGHSHELF + 1] = { "LOWPASS", "HIGHPASS", "BANDPASS", "NOTCH",
+    "PEAK", "LOWSHELF", "HIGHSHELF" };
+
+//stages of the filter graph benchmark and check, in order
+const int g_graph_types[FG_MAX_STAGES] = { LOWPASS, PEAK, HIGHPASS, LOWSHELF, NOTCH,
+    HIGHSHELF, BANDPASS, LOWPASS };
+const float g_graph_ratios[FG_MAX_STAGES] = { 1.f, .5f, .1f, .25f, 2.f, 1.5f, .75f, 1.2f };
+
+//the first four are indexed by OSC_WAVEFORMS
+golden_case g_golden[GOLDEN_COUNT] = {
+    { "sine", 1, 0, GOLDEN_SNR_OSC },
+    { "tri", 1, 0, GOLDEN_SNR_OSC },
+    { "saw", 1, 0, GOLDEN_SNR_OSC },
+    { "square", 1, 0, GOLDEN_SNR_OSC },
+    { "cutoff_sweep", 1, 1, GOLDEN_SNR_FILTER },
+    { "riser", 2, 7, GOLDEN_SNR_FILTER },
+};
+
+//-----------------------------------------------------------------------------
+// Name: record( )
+// Desc: keeps a measurement for the JSON output
+//-----------------------------------------------------------------------------
+static void record(const char *group, const char *name, const char *unit,
+        int block, int channels, double ns) {
+    bench_result *r;
+    if (g_result_count == MAX_RESULTS) {
+        return;
+    }
+    r = &g_results[g_result_count++];
+    r->group = group;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->unit = unit;
+    r->block = block;
+    r->channels = channels;
+    r->ns = ns;
+}
+
+//-----------------------------------------------------------------------------
+// Name: print_json( )
+// Desc: every measurement as one JSON document on stdout
+//-----------------------------------------------------------------------------
+static void print_json(void) {
+    int i;
+    printf("{\n");
+    printf("  \"compiler\": \"%s\",\n", __VERSION__);
+    printf("  \"flags\": \"%s\",\n", BENCH_CFLAGS);
+    printf("  \"sample_rate\": %d,\n", SAMPLE_RATE);
+    printf("  \"results\": [\n");
+    for (i = 0; i < g_result_count; i++) {
+        bench_result *r = &g_results[i];
+        printf("    {\"group\": \"%s\", \"name\": \"%s\", \"block\": %d, "
+                "\"channels\": %d, \"ns_per_%s\": %.3f, \"%ss_per_sec\": %.0f}%s\n",
+                r->group, r->name, r->block, r->channels, r->unit, r->ns,
+                r->unit, r->ns > 0 ? 1e9 / r->ns : 0., i + 1 < g_result_count ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+//-----------------------------------------------------------------------------
+// Name: now_seconds( )
+// Desc: monotonic clock in seconds
+//-----------------------------------------------------------------------------
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//-----------------------------------------------------------------------------
+// Name: thd_plus_noise( )
+// Desc: fits a sinusoid at exactly `cycles` periods over the buffer and
+//       returns the level of everything else relative to it, in dB
+//-----------------------------------------------------------------------------
+static double thd_plus_noise(const float *buffer, int length, int cycles) {
+    double re = 0, im = 0, residual = 0, fundamental;
+    int i;
+
+    for (i = 0; i < length; i++) {
+        double angle = 2. * PI * cycles * i / length;
+        re += buffer[i] * cos(angle);
+        im += buffer[i] * sin(angle);
+    }
+    re *= 2. / length;
+    im *= 2. / length;
+
+    for (i = 0; i < length; i++) {
+        double angle = 2. * PI * cycles * i / length;
+        double error = buffer[i] - (re * cos(angle) + im * sin(angle));
+        residual += error * error;
+    }
+    fundamental = (re * re + im * im) / 2. * length;
+
+    return 10. * log10(residual / fundamental + 1e-30);
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_sine( )
+// Desc: ns/sample and THD+N for every sine implementation
+//-----------------------------------------------------------------------------
+static void bench_sine(float *buffer) {
+    int mode, i;
+    oscillator osc;
+    double start, elapsed, sink = 0;
+
+    fprintf(g_text, "sine oscillator\n");
+    fprintf(g_text, "%-12s %12s %14s\n", "variant", "ns/sample", "THD+N (dB)");
+
+    for (mode = 0; mode < SINE_MODE_COUNT; mode++) {
+        //timing, in blocks like the callback renders them
+        osc_init(&osc, OSC_SINE, 440.f, SAMPLE_RATE);
+        osc_set_sine_mode(&osc, mode);
+        start = now_seconds();
+        for (i = 0; i < BENCH_SAMPLES; i += BLOCK_SIZE) {
+            osc_process_block(&osc, buffer, BLOCK_SIZE);
+            sink += buffer[0];
+        }
+        elapsed = now_seconds() - start;
+
+        //accuracy, at a frequency that fits the analysis window exactly
+        osc_init(&osc, OSC_SINE, (float)THD_CYCLES * SAMPLE_RATE / THD_SAMPLES, SAMPLE_RATE);
+        osc_set_sine_mode(&osc, mode);
+        osc_process_block(&osc, buffer, THD_SAMPLES);
+
+        fprintf(g_text, "%-12s %12.2f %14.1f\n", osc_sine_mode_name(mode),
+                elapsed * 1e9 / BENCH_SAMPLES,
+                thd_plus_noise(buffer, THD_SAMPLES, THD_CYCLES));
+        record("sine", osc_sine_mode_name(mode), "sample", BLOCK_SIZE, 1,
+                elapsed * 1e9 / BENCH_SAMPLES);
+    }
+
+    //keeps the timed loops from being optimized away
+    if (sink == 12345.) {
+        fprintf(g_text, "\n");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_exp2( )
+// Desc: ns/call and worst relative error of pm_exp2 against libm over the
+//       range the pad and the rises use
+//-----------------------------------------------------------------------------
+static void bench_exp2(void) {
+    int i;
+    double start, elapsed, worst = 0, sink = 0;
+    pitch_map map;
+
+    pm_init(&map, 27.5f, 1760.f);
+
+    start = now_seconds();
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        sink += pm_exp2(-8.f + 16.f * i / BENCH_SAMPLES);
+    }
+    elapsed = now_seconds() - start;
+
+    for (i = 0; i < THD_SAMPLES; i++) {
+        double x = -8. + 16. * i / THD_SAMPLES;
+        double error = fabs(pm_exp2((float)x) / pow(2., (float)x) - 1.);
+        if (error > worst) {
+            worst = error;
+        }
+    }
+
+    fprintf(g_text, "\nexp2 table (%d segments)\n", PM_TABLE_SIZE);
+    fprintf(g_text, "%-12s %12.2f\n", "ns/call", elapsed * 1e9 / BENCH_SAMPLES);
+    record("pitch_map", "pm_exp2", "call", 0, 1, elapsed * 1e9 / BENCH_SAMPLES);
+    fprintf(g_text, "%-12s %12.2e\n", "max rel err", worst);
+    fprintf(g_text, "%-12s %12.4f\n", "cents", 1200. * log2(1. + worst));
+
+    if (sink == 12345.) {
+        fprintf(g_text, "\n");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_waveforms( )
+// Desc: ns/sample of every waveform, sine from the table
+//-----------------------------------------------------------------------------
+static void bench_waveforms(float *buffer) {
+    static const char *names[] = { "sine", "tri", "saw", "square" };
+    int waveform, i;
+    oscillator osc;
+    double start, elapsed, sink = 0;
+
+    fprintf(g_text, "\noscillator\n");
+    fprintf(g_text, "%-12s %12s %14s\n", "waveform", "ns/sample", "Msamples/s");
+
+    for (waveform = OSC_SINE; waveform <= OSC_SQUARE; waveform++) {
+        osc_init(&osc, waveform, 440.f, SAMPLE_RATE);
+        osc_set_sine_mode(&osc, SINE_TABLE);
+        start = now_seconds();
+        for (i = 0; i < BENCH_SAMPLES; i += BLOCK_SIZE) {
+            osc_process_block(&osc, buffer, BLOCK_SIZE);
+            sink += buffer[0];
+        }
+        elapsed = now_seconds() - start;
+
+        fprintf(g_text, "%-12s %12.2f %14.1f\n", names[waveform],
+                elapsed * 1e9 / BENCH_SAMPLES, BENCH_SAMPLES / elapsed * 1e-6);
+        record("oscillator", names[waveform], "sample", BLOCK_SIZE, 1,
+                elapsed * 1e9 / BENCH_SAMPLES);
+    }
+
+    if (sink == 12345.) {
+        fprintf(g_text, "\n");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: alias_floor( )
+// Desc: ALIAS_SIZE samples of a waveform at exactly ALIAS_CYCLES periods:
+//       the harmonics land on bins k * ALIAS_CYCLES and everything folded
+//       back from above Nyquist between them. Returns the inharmonic power
+//       over the harmonic power in dB
+//-----------------------------------------------------------------------------
+static double alias_floor(fft *f, const float *buffer) {
+    double harmonic = 0, alias = 0;
+    int k;
+
+    fft_real(f, buffer, f->spectrum);
+    for (k = 1; k <= ALIAS_SIZE / 2; k++) {
+        double power = (double)f->spectrum[k].re * f->spectrum[k].re
+            + (double)f->spectrum[k].im * f->spectrum[k].im;
+        if (k % ALIAS_CYCLES == 0) {
+            harmonic += power;
+        } else {
+            alias += power;
+        }
+    }
+    return 10. * log10(alias / harmonic + 1e-30);
+}
+
+//-----------------------------------------------------------------------------
+// Name: polyblep_saw( )
+// Desc: the oscillator's saw with its PolyBLEP correction at the jump,
+//       as a plain loop. Returns the phase to go on from
+//-----------------------------------------------------------------------------
+static double polyblep_saw(double phase, double increment, float *out, int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        double t = phase;
+        double value = 2. * t - 1.;
+
+        //residual of a band-limited step, one sample each side of the jump
+        if (t < increment) {
+            t /= increment;
+            value -= t + t - t * t - 1.;
+        } else if (t > 1. - increment) {
+            t = (t - 1.) / increment;
+            value -= t * t + t + t + 1.;
+        }
+        out[i] = (float)value;
+
+        phase += increment;
+        if (phase >= 1.) {
+            phase -= 1.;
+        }
+    }
+    return phase;
+}
+
+//-----------------------------------------------------------------------------
+// Name: build_wavetables( )
+// Desc: mip-mapped saw, the other band-limiting the oscillator could use:
+//       level k sums the first 2^k harmonics of 2t - 1, so it is alias
+//       free as long as 2^k harmonics fit below Nyquist
+//-----------------------------------------------------------------------------
+static void build_wavetables(float tables[][WAVETABLE_SIZE + 1]) {
+    static double sine[WAVETABLE_SIZE];
+    static double sum[WAVETABLE_SIZE];
+    int level, h = 1, i;
+
+    for (i = 0; i < WAVETABLE_SIZE; i++) {
+        sine[i] = sin(2. * PI * i / WAVETABLE_SIZE);
+        sum[i] = 0.;
+    }
+    //each level adds the harmonics up to 2^k to the one below it
+    for (level = 0; level < WAVETABLE_LEVELS; level++) {
+        for (; h <= (1 << level) && h < WAVETABLE_SIZE / 2; h++) {
+            for (i = 0; i < WAVETABLE_SIZE; i++) {
+                sum[i] -= 2. / (PI * h) * sine[(h * i) % WAVETABLE_SIZE];
+            }
+        }
+        for (i = 0; i < WAVETABLE_SIZE; i++) {
+            tables[level][i] = (float)sum[i];
+        }
+        //guard point for the interpolation
+        tables[level][WAVETABLE_SIZE] = tables[level][0];
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: wavetable_saw( )
+// Desc: n samples from the fullest level whose harmonics all fit below
+//       Nyquist at increment, linearly interpolated. Returns the phase to
+//       go on from
+//-----------------------------------------------------------------------------
+static double wavetable_saw(float tables[][WAVETABLE_SIZE + 1], double phase,
+                            double increment, float *out, int n) {
+    const float *table;
+    int level, i;
+
+    //2^level harmonics <= 0.5 / increment
+    frexp(0.5 / increment, &level);
+    level = (level - 1 < WAVETABLE_LEVELS - 1) ? level - 1 : WAVETABLE_LEVELS - 1;
+    table = tables[level < 0 ? 0 : level];
+
+    for (i = 0; i < n; i++) {
+        double position = phase * WAVETABLE_SIZE;
+        int index = (int)position;
+        float frac = (float)(position - index);
+        out[i] = table[index] + frac * (table[index + 1] - table[index]);
+        phase += increment;
+        if (phase >= 1.) {
+            phase -= 1.;
+        }
+    }
+    return phase;
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_wavetable( )
+// Desc: the oscillator's PolyBLEP saw against a mip-mapped wavetable saw,
+//       both as the same kind of loop outside the oscillator so only the
+//       band-limiting differs: ns/sample at 440 Hz and alias_floor at the
+//       aliasing check's frequency
+//-----------------------------------------------------------------------------
+static void bench_wavetable(void) {
+    static float tables[WAVETABLE_LEVELS][WAVETABLE_SIZE + 1];
+    float *buffer = (float*)malloc(ALIAS_SIZE * sizeof(float));
+    fft *f = fft_new(ALIAS_SIZE);
+    double increment = 440. / SAMPLE_RATE, phase = 0, sink = 0;
+    double start, blep_time, table_time, blep_floor, table_floor;
+    int i;
+
+    if (buffer == NULL || f == NULL) {
+        fprintf(stderr, "Error while allocating memory for the wavetable benchmark\n");
+        free(buffer);
+        fft_destroy(f);
+        return;
+    }
+    build_wavetables(tables);
+
+    start = now_seconds();
+    for (i = 0; i < BENCH_SAMPLES; i += BLOCK_SIZE) {
+        phase = polyblep_saw(phase, increment, buffer, BLOCK_SIZE);
+        sink += buffer[0];
+    }
+    blep_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (i = 0; i < BENCH_SAMPLES; i += BLOCK_SIZE) {
+        phase = wavetable_saw(tables, phase, increment, buffer, BLOCK_SIZE);
+        sink += buffer[0];
+    }
+    table_time = now_seconds() - start;
+
+    polyblep_saw(0., (double)ALIAS_CYCLES / ALIAS_SIZE, buffer, ALIAS_SIZE);
+    blep_floor = alias_floor(f, buffer);
+    wavetable_saw(tables, 0., (double)ALIAS_CYCLES / ALIAS_SIZE, buffer, ALIAS_SIZE);
+    table_floor = alias_floor(f, buffer);
+
+    fprintf(g_text, "\nsaw, PolyBLEP against mip-mapped wavetables (%d levels of %d)\n",
+            WAVETABLE_LEVELS, WAVETABLE_SIZE);
+    fprintf(g_text, "%-12s %12s %14s %12s\n", "variant", "ns/sample", "aliasing (dB)", "memory KB");
+    fprintf(g_text, "%-12s %12.2f %14.1f %12d\n", "polyblep",
+            blep_time * 1e9 / BENCH_SAMPLES, blep_floor, 0);
+    fprintf(g_text, "%-12s %12.2f %14.1f %12d\n", "wavetable",
+            table_time * 1e9 / BENCH_SAMPLES, table_floor, (int)(sizeof(tables) / 1024));
+    record("oscillator", "saw/polyblep", "sample", BLOCK_SIZE, 1, blep_time * 1e9 / BENCH_SAMPLES);
+    record("oscillator", "saw/wavetable", "sample", BLOCK_SIZE, 1, table_time * 1e9 / BENCH_SAMPLES);
+
+    if (sink == 12345.) {
+        fprintf(g_text, "\n");
+    }
+    fft_destroy(f);
+    free(buffer);
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_coefficients( )
+// Desc: ns/call of bq_new, of a full bq_init and of bq_load_coefficients
+//       alone, for every FILTER_TYPES entry
+//-----------------------------------------------------------------------------
+static void bench_coefficients(void) {
+    double start, new_time, init_time, load_time, sink = 0;
+    biquad bq;
+    char name[40];
+    int type, i;
+
+    fprintf(g_text, "\nbiquad coefficients\n");
+    fprintf(g_text, "%-12s %12s %12s %12s\n", "type", "bq_new ns", "bq_init ns", "load ns");
+
+    for (type = LOWPASS; type <= HIGHSHELF; type++) {
+        //allocation and trig, the cutoff moves so nothing is hoisted
+        start = now_seconds();
+        for (i = 0; i < SETUP_CALLS; i++) {
+            biquad *tmp = bq_new(type, 100.f + (i & 1023), 10.0, 6.0, SAMPLE_RATE);
+            sink += tmp->b0;
+            bq_destroy(tmp);
+        }
+        new_time = now_seconds() - start;
+
+        start = now_seconds();
+        for (i = 0; i < SETUP_CALLS; i++) {
+            bq_init(&bq, type, 100.f + (i & 1023), 10.0, 6.0, SAMPLE_RATE);
+            sink += bq.b0;
+        }
+        init_time = now_seconds() - start;
+
+        //the switch on its own, with the helper variables given
+        start = now_seconds();
+        for (i = 0; i < SETUP_CALLS; i++) {
+            float omega = 0.01f + (i & 1023) * 1e-4f;
+            bq_load_coefficients(&bq, type, 1.4125f, omega, omega, 1.f - omega,
+                    omega * .05f, 1.68f);
+            sink += bq.b0;
+        }
+        load_time = now_seconds() - start;
+
+        fprintf(g_text, "%-12s %12.2f %12.2f %12.2f\n", g_type_names[type],
+                new_time * 1e9 / SETUP_CALLS, init_time * 1e9 / SETUP_CALLS,
+                load_time * 1e9 / SETUP_CALLS);
+        snprintf(name, sizeof(name), "bq_new/%s", g_type_names[type]);
+        record("coefficients", name, "call", 0, 1, new_time * 1e9 / SETUP_CALLS);
+        snprintf(name, sizeof(name), "bq_init/%s", g_type_names[type]);
+        record("coefficients", name, "call", 0, 1, init_time * 1e9 / SETUP_CALLS);
+        snprintf(name, sizeof(name), "bq_load_coefficients/%s", g_type_names[type]);
+        record("coefficients", name, "call", 0, 1, load_time * 1e9 / SETUP_CALLS);
+    }
+
+    if (sink == 12345.) {
+        fprintf(g_text, "\n");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: response_error( )
+// Desc: largest difference between the responses of two coefficient sets
+//       (b0, b1, b2, a1, a2) over TABLE_POINTS frequencies from 20 Hz to
+//       20 kHz, in dB relative to the largest magnitude of `exact`
+//-----------------------------------------------------------------------------
+static double response_error(const double *exact, const double *other) {
+    double worst = 0, peak = 1e-300;
+    int p, k;
+
+    for (p = 0; p < TABLE_POINTS; p++) {
+        double omega = 2. * PI * 20. * pow(1000., (double)p / (TABLE_POINTS - 1)) / SAMPLE_RATE;
+        double re[2], im[2];
+        const double *c[2] = { exact, other };
+
+        //H = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+        for (k = 0; k < 2; k++) {
+            double nr = c[k][0] + c[k][1] * cos(omega) + c[k][2] * cos(2 * omega);
+            double ni = -c[k][1] * sin(omega) - c[k][2] * sin(2 * omega);
+            double dr = 1. + c[k][3] * cos(omega) + c[k][4] * cos(2 * omega);
+            double di = -c[k][3] * sin(omega) - c[k][4] * sin(2 * omega);
+            double d = dr * dr + di * di;
+            re[k] = (nr * dr + ni * di) / d;
+            im[k] = (ni * dr - nr * di) / d;
+        }
+        peak = fmax(peak, hypot(re[0], im[0]));
+        worst = fmax(worst, hypot(re[1] - re[0], im[1] - im[0]));
+    }
+    return 20. * log10(worst / peak + 1e-300);
+}
+
+//-----------------------------------------------------------------------------
+// Name: table_errors( )
+// Desc: worst response error against bq_design over TABLE_DESIGNS random
+//       cutoffs (20 Hz - 20 kHz) and Qs. errors[band][0] is that of the
+//       coefficient table, errors[band][1] that of the float formulas in
+//       bq_init, band 0 below TABLE_SPLIT. Returns 0 if there is no table
+//-----------------------------------------------------------------------------
+static int table_errors(int type, double errors[2][2]) {
+    const coef_table *ct = ct_get(type, TABLE_GAIN);
+    unsigned int seed = 7;
+    int d, c, band;
+
+    if (ct == NULL) {
+        return 0;
+    }
+
+    for (band = 0; band < 2; band++) {
+        errors[band][0] = errors[band][1] = -400.;
+    }
+    for (d = 0; d < TABLE_DESIGNS; d++) {
+        double design[6], exact[5], table[5], rounded[5];
+        float looked_up[5];
+        float frequency, q;
+        biquad bq;
+
+        seed = seed * 1664525u + 1013904223u;
+        frequency = 20.f * powf(1000.f, (float)seed / 4294967296.f);
+        seed = seed * 1664525u + 1013904223u;
+        q = TABLE_MIN_Q * pow(TABLE_MAX_Q / TABLE_MIN_Q, (double)seed / 4294967296.);
+        band = frequency >= TABLE_SPLIT;
+
+        bq_design(type, frequency, q, TABLE_GAIN, SAMPLE_RATE, design);
+        ct_lookup(ct, frequency, q, SAMPLE_RATE, looked_up);
+        bq_init(&bq, type, frequency, q, TABLE_GAIN, SAMPLE_RATE);
+        for (c = 0; c < 5; c++) {
+            exact[c] = design[c < 3 ? c : c + 1] / design[3];
+            table[c] = looked_up[c];
+        }
+        rounded[0] = bq.b0;
+        rounded[1] = bq.b1;
+        rounded[2] = bq.b2;
+        rounded[3] = bq.a1;
+        rounded[4] = bq.a2;
+        errors[band][0] = fmax(errors[band][0], response_error(exact, table));
+        errors[band][1] = fmax(errors[band][1], response_error(exact, rounded));
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_coefficient_table( )
+// Desc: ns/call of a retune through ct_set_target against bq_set_target,
+//       the per-sample cost of an audio-rate cutoff, and the accuracy of
+//       the table next to that of the float formulas
+//-----------------------------------------------------------------------------
+static void bench_coefficient_table(void) {
+    double start, exact_time, table_time, errors[2][2];
+    const coef_table *ct;
+    biquad bq;
+    char name[40];
+    int type, i;
+
+    fprintf(g_text, "\ncoefficient table, worst response error vs bq_design (dB), %d designs\n",
+            TABLE_DESIGNS);
+    fprintf(g_text, "%-12s %10s %10s %10s %10s %10s %10s\n", "type", "exact ns", "table ns",
+            "table<200", "float<200", "table200+", "float200+");
+
+    for (type = LOWPASS; type <= HIGHSHELF; type++) {
+        ct = ct_get(type, TABLE_GAIN);
+        if (ct == NULL || !table_errors(type, errors)) {
+            continue;
+        }
+
+        //a new cutoff every call, as under per-sample modulation
+        bq_init(&bq, type, 1000.f, 10.0, TABLE_GAIN, SAMPLE_RATE);
+        start = now_seconds();
+        for (i = 0; i < SETUP_CALLS; i++) {
+            bq_set_target(&bq, type, 100.f + (i & 1023), 10.0, TABLE_GAIN, SAMPLE_RATE, 0);
+        }
+        exact_time = now_seconds() - start;
+
+        start = now_seconds();
+        for (i = 0; i < SETUP_CALLS; i++) {
+            ct_set_target(ct, &bq, 100.f + (i & 1023), 10.0, SAMPLE_RATE, 0);
+        }
+        table_time = now_seconds() - start;
+
+        fprintf(g_text, "%-12s %10.2f %10.2f %10.1f %10.1f %10.1f %10.1f\n", g_type_names[type],
+                exact_time * 1e9 / SETUP_CALLS, table_time * 1e9 / SETUP_CALLS,
+                errors[0][0], errors[0][1], errors[1][0], errors[1][1]);
+        snprintf(name, sizeof(name), "bq_set_target/%s", g_type_names[type]);
+        record("coefficient_table", name, "call", 0, 1, exact_time * 1e9 / SETUP_CALLS);
+        snprintf(name, sizeof(name), "ct_set_target/%s", g_type_names[type]);
+        record("coefficient_table", name, "call", 0, 1, table_time * 1e9 / SETUP_CALLS);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: max_difference( )
+// Desc: largest absolute difference between two buffers
+//-----------------------------------------------------------------------------
+static double max_difference(const float *a, const float *b, int length) {
+    double worst = 0;
+    int i;
+    for (i = 0; i < length; i++) {
+        if (fabs(a[i] - b[i]) > worst) {
+            worst = fabs(a[i] - b[i]);
+        }
+    }
+    return worst;
+}
+
+//-----------------------------------------------------------------------------
+// Name: init_filters( )
+// Desc: one lowpass per channel, each at a different cutoff
+//-----------------------------------------------------------------------------
+static void init_filters(biquad *filters, biquad **pointers, int channels) {
+    int c;
+    for (c = 0; c < channels; c++) {
+        bq_init(&filters[c], LOWPASS, 400.f + 300.f * c, 10.0, 1.0, SAMPLE_RATE);
+        pointers[c] = &filters[c];
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_biquad( )
+// Desc: compares the block, cascade and interleaved biquad paths with
+//       bq_process, both for speed and for matching output
+//-----------------------------------------------------------------------------
+static void bench_biquad(void) {
+    static float input[BLOCK_SIZE * MAX_CHANNELS];
+    static float reference[BLOCK_SIZE * MAX_CHANNELS];
+    static float output[BLOCK_SIZE * MAX_CHANNELS];
+    biquad filters[MAX_CHANNELS], reference_filters[MAX_CHANNELS];
+    biquad *pointers[MAX_CHANNELS], *reference_pointers[MAX_CHANNELS];
+    biquad low, high, ref_low, ref_high;
+    oscillator osc;
+    double start, scalar_time, block_time, difference;
+    int blocks = BENCH_SAMPLES / BLOCK_SIZE;
+    int channels, b, i, c;
+
+    osc_init(&osc, OSC_SAW, 110.f, SAMPLE_RATE);
+    osc_process_block(&osc, input, BLOCK_SIZE * MAX_CHANNELS);
+
+    fprintf(g_text, "\nbiquad\n");
+    fprintf(g_text, "%-24s %12s %12s %14s\n", "path", "scalar ns", "block ns", "max |diff|");
+
+    //single filter, bq_process vs bq_process_block
+    init_filters(&low, pointers, 1);
+    init_filters(&ref_low, reference_pointers, 1);
+    start = now_seconds();
+    for (b = 0; b < blocks; b++) {
+        for (i = 0; i < BLOCK_SIZE; i++) {
+            reference[i] = bq_process(&ref_low, input[i]);
+        }
+    }
+    scalar_time = now_seconds() - start;
+    start = now_seconds();
+    for (b = 0; b < blocks; b++) {
+        bq_process_block(&low, input, output, BLOCK_SIZE);
+    }
+    block_time = now_seconds() - start;
+    difference = max_difference(reference, output, BLOCK_SIZE);
+    fprintf(g_text, "%-24s %12.2f %12.2f %14g\n", "bq_process_block",
+            scalar_time * 1e9 / BENCH_SAMPLES, block_time * 1e9 / BENCH_SAMPLES, difference);
+    record("biquad", "bq_process", "sample", BLOCK_SIZE, 1, scalar_time * 1e9 / BENCH_SAMPLES);
+    record("biquad", "bq_process_block", "sample", BLOCK_SIZE, 1, block_time * 1e9 / BENCH_SAMPLES);
+
+    //lowpass into highpass, nested bq_process vs bq_process_cascade
+    bq_init(&low, LOWPASS, 2000.f, 10.0, 1.0, SAMPLE_RATE);
+    bq_init(&high, HIGHPASS, 200.f, 10.0, 1.0, SAMPLE_RATE);
+    ref_low = low;
+    ref_high = high;
+    start = now_seconds();
+    for (b = 0; b < blocks; b++) {
+        for (i = 0; i < BLOCK_SIZE; i++) {
+            reference[i] = bq_process(&ref_high, bq_process(&ref_low, input[i]));
+        }
+    }
+    scalar_time = now_seconds() - start;
+    start = now_seconds();
+    for (b = 0; b < blocks; b++) {
+        bq_process_cascade(&low, &high, input, output, BLOCK_SIZE);
+    }
+    block_time = now_seconds() - start;
+    difference = max_difference(reference, output, BLOCK_SIZE);
+    fprintf(g_text, "%-24s %12.2f %12.2f %14g\n", "bq_process_cascade",
+            scalar_time * 1e9 / BENCH_SAMPLES, block_time * 1e9 / BENCH_SAMPLES, difference);
+    record("biquad", "bq_process x2", "sample", BLOCK_SIZE, 1, scalar_time * 1e9 / BENCH_SAMPLES);
+    record("biquad", "bq_process_cascade", "sample", BLOCK_SIZE, 1, block_time * 1e9 / BENCH_SAMPLES);
+
+    //one filter per channel, per-sample loop vs bq_process_interleaved
+    for (channels = 1; channels <= MAX_CHANNELS; channels *= 2) {
+        char name[32];
+        int frames = BLOCK_SIZE;
+        blocks = BENCH_SAMPLES / (BLOCK_SIZE * channels);
+
+        init_filters(filters, pointers, channels);
+        init_filters(reference_filters, reference_pointers, channels);
+        start = now_seconds();
+        for (b = 0; b < blocks; b++) {
+            for (i = 0; i < frames; i++) {
+                for (c = 0; c < channels; c++) {
+                    reference[i * channels + c] =
+                        bq_process(reference_pointers[c], input[i * channels + c]);
+                }
+            }
+        }
+        scalar_time = now_seconds() - start;
+        start = now_seconds();
+        for (b = 0; b < blocks; b++) {
+            bq_process_interleaved(pointers, channels, input, output, frames);
+        }
+        block_time = now_seconds() - start;
+        difference = max_difference(reference, output, frames * channels);
+        snprintf(name, sizeof(name), "bq_process_interleaved/%d", channels);
+        fprintf(g_text, "%-24s %12.2f %12.2f %14g\n", name,
+                scalar_time * 1e9 / (blocks * frames * channels),
+                block_time * 1e9 / (blocks * frames * channels), difference);
+        record("biquad", "bq_process_interleaved", "sample", frames, channels,
+                block_time * 1e9 / (blocks * frames * channels));
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: follow_graph( )
+// Desc: glides each channel's chain of biquads to the latest design of
+//       the graph's stages, as the graph glides itself
+//-----------------------------------------------------------------------------
+static void follow_graph(const filter_graph *fg, biquad chain[][FG_MAX_STAGES],
+                         int ramp_length) {
+    int c, s;
+    for (c = 0; c < fg->channels; c++) {
+        for (s = 0; s < fg->stages; s++) {
+            biquad next = chain[c][s];
+            next.b0 = fg->target[FG_B0][s];
+            next.b1 = fg->target[FG_B1][s];
+            next.b2 = fg->target[FG_B2][s];
+            next.a1 = fg->target[FG_A1][s];
+            next.a2 = fg->target[FG_A2][s];
+            bq_glide_to(&chain[c][s], &next, ramp_length);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: build_graph( )
+// Desc: the first stages of g_graph_types following GRAPH_BASE, and the
+//       same stages as a chain of biquads per channel
+//-----------------------------------------------------------------------------
+static void build_graph(filter_graph *fg, biquad chain[][FG_MAX_STAGES],
+                        int stages, int channels) {
+    int c, s;
+
+    fg_init(fg, channels, SAMPLE_RATE);
+    for (s = 0; s < stages; s++) {
+        fg_add_stage(fg, g_graph_types[s], GRAPH_BASE * g_graph_ratios[s], 1.f, 6.f);
+        fg_follow(fg, s, g_graph_ratios[s]);
+        for (c = 0; c < channels; c++) {
+            bq_init(&chain[c][s], g_graph_types[s], GRAPH_BASE * g_graph_ratios[s],
+                    1.f, 6.f, SAMPLE_RATE);
+        }
+    }
+    follow_graph(fg, chain, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_filter_graph( )
+// Desc: 1 to FG_MAX_STAGES stages over 1 and GRAPH_CHANNELS channels:
+//       bq_process per stage and sample, the stages chained as block
+//       calls, and fg_process. Difference against bq_process
+//-----------------------------------------------------------------------------
+static void bench_filter_graph(void) {
+    static float input[BLOCK_SIZE * GRAPH_CHANNELS];
+    static float reference[BLOCK_SIZE * GRAPH_CHANNELS];
+    static float chained[BLOCK_SIZE * GRAPH_CHANNELS];
+    static float output[BLOCK_SIZE * GRAPH_CHANNELS];
+    static filter_graph fg;
+    biquad scalar[GRAPH_CHANNELS][FG_MAX_STAGES], block[GRAPH_CHANNELS][FG_MAX_STAGES];
+    biquad *pointers[FG_MAX_STAGES][GRAPH_CHANNELS];
+    oscillator osc;
+    double start, scalar_time, block_time, graph_time, difference;
+    int stages, channels, blocks, b, i, c, s;
+
+    osc_init(&osc, OSC_SAW, 110.f, SAMPLE_RATE);
+    osc_process_block(&osc, input, BLOCK_SIZE * GRAPH_CHANNELS);
+
+    fprintf(g_text, "\nfilter graph (ns/sample)\n");
+    fprintf(g_text, "%-12s %12s %12s %12s %14s\n", "stages/ch", "bq_process", "chained",
+            "fg_process", "max |diff|");
+
+    for (channels = 1; channels <= GRAPH_CHANNELS; channels *= 2) {
+        blocks = BENCH_SAMPLES / (BLOCK_SIZE * channels);
+        for (stages = 1; stages <= FG_MAX_STAGES; stages *= 2) {
+            char name[32];
+
+            build_graph(&fg, scalar, stages, channels);
+            memcpy(block, scalar, sizeof(block));
+            for (s = 0; s < stages; s++) {
+                for (c = 0; c < channels; c++) {
+                    pointers[s][c] = &block[c][s];
+                }
+            }
+
+            //a call per stage, channel and sample
+            start = now_seconds();
+            for (b = 0; b < blocks; b++) {
+                for (i = 0; i < BLOCK_SIZE; i++) {
+                    for (c = 0; c < channels; c++) {
+                        float x = input[i * channels + c];
+                        for (s = 0; s < stages; s++) {
+                            x = bq_process(&scalar[c][s], x);
+                        }
+                        reference[i * channels + c] = x;
+                    }
+                }
+            }
+            scalar_time = now_seconds() - start;
+
+            //a block call per stage
+            start = now_seconds();
+            for (b = 0; b < blocks; b++) {
+                for (s = 0; s < stages; s++) {
+                    const float *from = (s == 0) ? input : chained;
+                    if (channels == 1) {
+                        bq_process_block(&block[0][s], from, chained, BLOCK_SIZE);
+                    } else {
+                        bq_process_interleaved(pointers[s], channels, from, chained, BLOCK_SIZE);
+                    }
+                }
+            }
+            block_time = now_seconds() - start;
+
+            start = now_seconds();
+            for (b = 0; b < blocks; b++) {
+                fg_process(&fg, input, output, BLOCK_SIZE);
+            }
+            graph_time = now_seconds() - start;
+
+            difference = max_difference(reference, output, BLOCK_SIZE * channels);
+            if (max_difference(reference, chained, BLOCK_SIZE * channels) > difference) {
+                difference = max_difference(reference, chained, BLOCK_SIZE * channels);
+            }
+            scalar_time *= 1e9 / ((double)blocks * BLOCK_SIZE * channels);
+            block_time *= 1e9 / ((double)blocks * BLOCK_SIZE * channels);
+            graph_time *= 1e9 / ((double)blocks * BLOCK_SIZE * channels);
+
+            snprintf(name, sizeof(name), "%d/%d", stages, channels);
+            fprintf(g_text, "%-12s %12.2f %12.2f %12.2f %14g\n", name,
+                    scalar_time, block_time, graph_time, difference);
+            snprintf(name, sizeof(name), "bq_process/%d", stages);
+            record("filter_graph", name, "sample", BLOCK_SIZE, channels, scalar_time);
+            snprintf(name, sizeof(name), "chained/%d", stages);
+            record("filter_graph", name, "sample", BLOCK_SIZE, channels, block_time);
+            snprintf(name, sizeof(name), "fg_process/%d", stages);
+            record("filter_graph", name, "sample", BLOCK_SIZE, channels, graph_time);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: reference_lowpass( )
+// Desc: RBJ lowpass in long double, coefficients and state, the
+//       reference the topologies are measured against
+//-----------------------------------------------------------------------------
+static void reference_lowpass(double frequency, const float *in, double *out, int n) {
+    long double omega = 2.L * PI * frequency / SAMPLE_RATE;
+    long double cs = cosl(omega);
+    long double alpha = sinl(omega) / (2.L * TOPOLOGY_Q);
+    long double a0 = 1.L + alpha;
+    long double b0 = (1.L - cs) / 2.L / a0, b1 = (1.L - cs) / a0;
+    long double a1 = -2.L * cs / a0, a2 = (1.L - alpha) / a0;
+    long double s1 = 0, s2 = 0, y;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        y = b0 * in[i] + s1;
+        s1 = b1 * in[i] - a1 * y + s2;
+        s2 = b0 * in[i] - a2 * y;
+        out[i] = (double)y;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_topologies( )
+// Desc: every biquad topology as a Q 10 lowpass: ns/sample with fixed and
+//       with gliding coefficients, SNR against the long double reference
+//       at a low and a mid cutoff, and ns/sample of a tail decaying into
+//       denormals with and without bq_flush_denormals
+//-----------------------------------------------------------------------------
+static void bench_topologies(void) {
+    static const float cutoffs[] = { 20.f, 1000.f };
+    float *input = (float*)malloc(TOPOLOGY_SAMPLES * sizeof(float));
+    float *output = (float*)malloc(TOPOLOGY_SAMPLES * sizeof(float));
+    double *reference = (double*)malloc(2 * TOPOLOGY_SAMPLES * sizeof(double));
+    double fixed, glide, snr[2], tail[2];
+    biquad bq, targets[2];
+    char name[40];
+    unsigned int seed = 1;
+    int topology, c, i, flush;
+
+    if (input == NULL || output == NULL || reference == NULL) {
+        fprintf(stderr, "Error while allocating memory for the topology benchmark\n");
+        free(input);
+        free(output);
+        free(reference);
+        return;
+    }
+
+    //white noise, the same for every topology
+    for (i = 0; i < TOPOLOGY_SAMPLES; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        input[i] = (float)seed / 2147483648.f - 1.f;
+    }
+    for (c = 0; c < 2; c++) {
+        reference_lowpass(cutoffs[c], input, reference + c * TOPOLOGY_SAMPLES, TOPOLOGY_SAMPLES);
+    }
+
+    fprintf(g_text, "\nbiquad topologies, lowpass Q %.0f\n", TOPOLOGY_Q);
+    fprintf(g_text, "%-8s %9s %9s %11s %11s %13s %13s\n", "topology", "fixed ns", "glide ns",
+            "SNR 20 Hz", "SNR 1 kHz", "tail ns", "flushed ns");
+
+    for (topology = 0; topology < BQ_TOPOLOGY_COUNT; topology++) {
+        double start;
+
+        //fixed coefficients, one block at a time
+        bq_init(&bq, LOWPASS, 1000.f, TOPOLOGY_Q, 0, SAMPLE_RATE);
+        bq_set_topology(&bq, topology);
+        start = now_seconds();
+        for (i = 0; i + BLOCK_SIZE <= BENCH_SAMPLES; i += BLOCK_SIZE) {
+            bq_process_block(&bq, input + (i % TOPOLOGY_SAMPLES), output, BLOCK_SIZE);
+        }
+        fixed = (now_seconds() - start) * 1e9 / BENCH_SAMPLES;
+
+        //a new glide every AU_STEP samples, as under a rise
+        for (c = 0; c < 2; c++) {
+            bq_init(&targets[c], LOWPASS, 1000.f + 100.f * c, TOPOLOGY_Q, 0, SAMPLE_RATE);
+            bq_set_topology(&targets[c], topology);
+        }
+        start = now_seconds();
+        for (i = 0; i + AU_STEP <= BENCH_SAMPLES; i += AU_STEP) {
+            bq_glide_to(&bq, &targets[(i / AU_STEP) & 1], AU_STEP);
+            bq_process_block(&bq, input + (i % TOPOLOGY_SAMPLES), output, AU_STEP);
+        }
+        glide = (now_seconds() - start) * 1e9 / BENCH_SAMPLES;
+
+        //error against the long double reference
+        for (c = 0; c < 2; c++) {
+            const double *ref = reference + c * TOPOLOGY_SAMPLES;
+            double signal = 0, noise = 0;
+
+            bq_init(&bq, LOWPASS, cutoffs[c], TOPOLOGY_Q, 0, SAMPLE_RATE);
+            bq_set_topology(&bq, topology);
+            bq_process_block(&bq, input, output, TOPOLOGY_SAMPLES);
+            for (i = 0; i < TOPOLOGY_SAMPLES; i++) {
+                signal += ref[i] * ref[i];
+                noise += (output[i] - ref[i]) * (output[i] - ref[i]);
+            }
+            snr[c] = 10. * log10(signal / (noise + 1e-300));
+        }
+
+        //a small impulse at the low cutoff rings down through the denormals
+        for (flush = 0; flush <= 1; flush++) {
+            bq_flush_denormals(flush);
+            bq_init(&bq, LOWPASS, cutoffs[0], TOPOLOGY_Q, 0, SAMPLE_RATE);
+            bq_set_topology(&bq, topology);
+            memset(output, 0, BLOCK_SIZE * sizeof(float));
+            output[0] = 1e-30f;
+            start = now_seconds();
+            for (i = 0; i < DENORMAL_SAMPLES; i += BLOCK_SIZE) {
+                bq_process_block(&bq, output, output, BLOCK_SIZE);
+                memset(output, 0, BLOCK_SIZE * sizeof(float));
+            }
+            tail[flush] = (now_seconds() - start) * 1e9 / DENORMAL_SAMPLES;
+        }
+        bq_flush_denormals(0);
+
+        fprintf(g_text, "%-8s %9.2f %9.2f %11.1f %11.1f %13.2f %13.2f\n",
+                g_topology_names[topology], fixed, glide, snr[0], snr[1], tail[0], tail[1]);
+        snprintf(name, sizeof(name), "%s/fixed", g_topology_names[topology]);
+        record("topology", name, "sample", BLOCK_SIZE, 1, fixed);
+        snprintf(name, sizeof(name), "%s/glide", g_topology_names[topology]);
+        record("topology", name, "sample", AU_STEP, 1, glide);
+        snprintf(name, sizeof(name), "%s/denormal_tail", g_topology_names[topology]);
+        record("topology", name, "sample", BLOCK_SIZE, 1, tail[0]);
+        snprintf(name, sizeof(name), "%s/flushed_tail", g_topology_names[topology]);
+        record("topology", name, "sample", BLOCK_SIZE, 1, tail[1]);
+    }
+
+    free(input);
+    free(output);
+    free(reference);
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_voices( )
+// Desc: cost of a 1024-frame stereo block for growing voice counts, and
+//       how many voices fit in the time one block lasts
+//-----------------------------------------------------------------------------
+static void bench_voices(void) {
+    static float output[BLOCK_SIZE * 2];
+    double budget = (double)BLOCK_SIZE / SAMPLE_RATE;
+    double start, per_block, per_voice = 0;
+    char name[40];
+    int voices, v, b;
+    int blocks = 200;
+
+    fprintf(g_text, "\nvoice pool, %d-frame stereo blocks (budget %.0f us)\n", BLOCK_SIZE, budget * 1e6);
+    fprintf(g_text, "%-8s %14s %10s\n", "voices", "us/block", "% budget");
+
+    for (voices = 1; voices <= VP_MAX_VOICES; voices *= 2) {
+        voice_pool *pool = vp_new(voices, 2, BLOCK_SIZE, SAMPLE_RATE, 10.0);
+        vp_set_cutoffs(pool, 2000.f, 300.f, 0);
+        for (v = 0; v < voices; v++) {
+            vp_note_on(pool, 1.f + 0.001f * v, (float)v / voices, 1.f, OSC_SAW, SINE_TABLE);
+        }
+
+        start = now_seconds();
+        for (b = 0; b < blocks; b++) {
+            vp_render(pool, NULL, 220.f, 1.f, output, BLOCK_SIZE);
+        }
+        per_block = (now_seconds() - start) / blocks;
+        per_voice = per_block / voices;
+
+        fprintf(g_text, "%-8d %14.1f %10.2f\n", voices, per_block * 1e6, 100. * per_block / budget);
+        snprintf(name, sizeof(name), "vp_render/%d voices", voices);
+        record("voice_pool", name, "sample", BLOCK_SIZE, 2, per_block * 1e9 / BLOCK_SIZE);
+        vp_destroy(pool);
+    }
+
+    fprintf(g_text, "voices that fit in one block: %d\n", (int)(budget / per_voice));
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_threads( )
+// Desc: the same voice load rendered with 0 .. cores-1 helper threads
+//-----------------------------------------------------------------------------
+static void bench_threads(void) {
+    static float output[BLOCK_SIZE * 2];
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int voices = VP_MAX_VOICES;
+    int frames, workers, v, b;
+    int blocks = 200;
+    double single = 0;
+    char name[40];
+
+    fprintf(g_text, "\njob pool, %d voices\n", voices);
+    fprintf(g_text, "%-8s %-8s %14s %10s\n", "frames", "threads", "us/block", "speedup");
+
+    for (frames = 256; frames <= BLOCK_SIZE; frames *= 4) {
+        for (workers = 0; workers < cores && workers <= JP_MAX_WORKERS; workers++) {
+            voice_pool *pool = vp_new(voices, 2, BLOCK_SIZE, SAMPLE_RATE, 10.0);
+            job_pool *jobs = (workers > 0) ? jp_new(workers, true) : NULL;
+            double start, per_block;
+
+            vp_set_cutoffs(pool, 2000.f, 300.f, 0);
+            for (v = 0; v < voices; v++) {
+                vp_note_on(pool, 1.f + 0.001f * v, (float)v / voices, 1.f, OSC_SAW, SINE_TABLE);
+            }
+
+            start = now_seconds();
+            for (b = 0; b < blocks; b++) {
+                vp_render(pool, jobs, 220.f, 1.f, output, frames);
+            }
+            per_block = (now_seconds() - start) / blocks;
+            if (workers == 0) {
+                single = per_block;
+            }
+
+            fprintf(g_text, "%-8d %-8d %14.1f %10.2f\n", frames, workers + 1,
+                    per_block * 1e6, single / per_block);
+            snprintf(name, sizeof(name), "vp_render/%d threads", workers + 1);
+            record("job_pool", name, "sample", frames, 2, per_block * 1e9 / frames);
+            jp_destroy(jobs);
+            vp_destroy(pool);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_render( )
+// Desc: the callback's per-block work through the engine, the DETUNED x7
+//       stack of saws with a cutoff change every block, swept over block
+//       sizes and channel counts; once with the pad and once under a
+//       running rise, which renders in AU_STEP steps
+//-----------------------------------------------------------------------------
+static void bench_render(void) {
+    static const int channel_counts[] = { 1, 2, 8 };
+    static float output[4096 * MAX_CHANNELS];
+    riser_automation rise = { 1, 1, AU_LOG_FREQ, 1000.f, 220.f, 1760.f, 27.5f, 1760.f };
+    riser_params params;
+    int block, c, rising;
+
+    fprintf(g_text, "\nrender, %d voices\n", RENDER_VOICES);
+    fprintf(g_text, "%-8s %-8s %-8s %12s %14s\n", "block", "channels", "rise",
+            "ns/frame", "Mframes/s");
+
+    for (rising = 0; rising <= 1; rising++) {
+        for (c = 0; c < 3; c++) {
+            for (block = 32; block <= 4096; block *= 2) {
+                int channels = channel_counts[c];
+                long blocks = RENDER_SAMPLES / block;
+                riser_engine *engine;
+                double start, elapsed;
+                long b;
+
+                memset(&params, 0, sizeof(params));
+                params.frequency = 220.f;
+                params.amplitude = 1;
+                params.wavetype = OSC_SAW;
+                params.sine_mode = SINE_TABLE;
+                params.stack = RENDER_STACK;
+                params.highpass_freq = 200.f;
+                if (rising) {
+                    params.automation = rise;
+                }
+
+                engine = re_new(RENDER_VOICES, channels, block, SAMPLE_RATE, 0, &params);
+                if (engine == NULL) {
+                    return;
+                }
+
+                start = now_seconds();
+                for (b = 0; b < blocks; b++) {
+                    params.lowpass_freq = 400.f + (b & 255);
+                    re_render_params(engine, &params, output, block);
+                }
+                elapsed = now_seconds() - start;
+
+                fprintf(g_text, "%-8d %-8d %-8s %12.2f %14.2f\n", block, channels,
+                        rising ? "yes" : "no", elapsed * 1e9 / (blocks * block),
+                        blocks * block / elapsed * 1e-6);
+                record("render", rising ? "rise" : "pad", "sample", block, channels,
+                        elapsed * 1e9 / (blocks * block));
+                re_destroy(engine);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Name: bench_fft()
+// Desc: Times the waterfall analyser, one windowed block to dB magnitudes
+//       per display frame, and checks a bin-centred sine reads 0 dB
+//-----------------------------------------------------------------------------
+static void bench_fft(void) {
+    float block[BLOCK_SIZE], window[BLOCK_SIZE], db[BLOCK_SIZE / 2];
+    float gain = 0.f;
+    double start, elapsed, sink = 0;
+    int i, frame;
+    fft *f = fft_new(BLOCK_SIZE);
+
+    if (f == NULL) {
+        return;
+    }
+
+    for (i = 0; i < BLOCK_SIZE; i++) {
+        window[i] = (float)(0.5 * (1.0 - cos(2 * PI * i / BLOCK_SIZE)));
+        gain += window[i];
+    }
+    gain /= BLOCK_SIZE;
+
+    start = now_seconds();
+    for (frame = 0; frame < FFT_FRAMES; frame++) {
+        for (i = 0; i < BLOCK_SIZE; i++) {
+            block[i] = (float)sin(2 * PI * 37 * i / BLOCK_SIZE) * window[i];
+        }
+        fft_magnitude_db(f, block, db, gain, -160.f);
+        sink += db[frame % (BLOCK_SIZE / 2)];
+    }
+    elapsed = now_seconds() - start;
+
+    fprintf(g_text, "\nspectrum analyser (%d point real FFT)\n", BLOCK_SIZE);
+    fprintf(g_text, "%-12s %12.2f\n", "us/frame", elapsed * 1e6 / FFT_FRAMES);
+    record("fft", "fft_magnitude_db", "call", BLOCK_SIZE, 1, elapsed * 1e9 / FFT_FRAMES);
+    fprintf(g_text, "%-12s %12.2f\n", "peak (dB)", db[37]);
+
+    if (sink == 12345.) {
+        fprintf(g_text, "\n");
+    }
+    fft_destroy(f);
+}
+
+//-----------------------------------------------------------------------------
+// Name: render_golden( )
+// Desc: renders golden case `which` into out, GOLDEN_FRAMES frames of
+//       g_golden[which].channels channels. Every case is a fixed script, so
+//       the output only changes when the DSP code does
+//-----------------------------------------------------------------------------
+static void render_golden(int which, float *out) {
+    //rises from below RE_HIGHPASS_OFFSET, so the highpass starts clamped
+    riser_automation rise = { 1, 1, AU_LOG_FREQ, (float)GOLDEN_FRAMES / SAMPLE_RATE,
+        110.f, 880.f, 100.f, 8000.f };
+    const golden_case *gc = &g_golden[which];
+    voice_pool *pool;
+    riser_engine *engine;
+    riser_params params;
+    oscillator osc;
+    int b;
+
+    //the four waveforms at 440 Hz, straight from the oscillator
+    if (which <= OSC_SQUARE) {
+        osc_init(&osc, which, 440.f, SAMPLE_RATE);
+        osc_process_block(&osc, out, GOLDEN_FRAMES);
+        return;
+    }
+
+    if (which == GOLDEN_SWEEP) {
+        pool = vp_new(gc->voices, gc->channels, GOLDEN_BLOCK, SAMPLE_RATE, RE_FILTER_Q);
+        if (pool == NULL) {
+            memset(out, 0, GOLDEN_FRAMES * gc->channels * sizeof(float));
+            return;
+        }
+        //one saw, lowpass swept from 100 Hz to 10 kHz gliding every block
+        vp_set_cutoffs(pool, 100.f, 20.f, 0);
+        vp_note_on(pool, 1.f, .5f, .4f, OSC_SAW, SINE_LIBM);
+        for (b = 0; b < GOLDEN_FRAMES / GOLDEN_BLOCK; b++) {
+            float lowpass = 100.f * powf(100.f, (float)b * GOLDEN_BLOCK / GOLDEN_FRAMES);
+            vp_set_cutoffs(pool, lowpass, 20.f, GOLDEN_BLOCK);
+            vp_render(pool, NULL, 110.f, 1.f, out + b * GOLDEN_BLOCK, GOLDEN_BLOCK);
+        }
+        vp_destroy(pool);
+        return;
+    }
+
+    //the DETUNED x7 stack of saws under a rise, through the engine as the
+    //app renders it; a quarter in, the shape and then the topology change
+    memset(&params, 0, sizeof(params));
+    params.frequency = 110.f;
+    params.amplitude = 1;
+    params.wavetype = OSC_SAW;
+    params.sine_mode = SINE_LIBM;
+    params.stack = RENDER_STACK;
+    params.lowpass_freq = 1000.f;
+    params.highpass_freq = 20.f;
+    params.topology = BQ_DF1;
+    params.shape = 0;
+    params.automation = rise;
+
+    engine = re_new(gc->voices, gc->channels, GOLDEN_BLOCK, SAMPLE_RATE, 0, &params);
+    if (engine == NULL) {
+        memset(out, 0, GOLDEN_FRAMES * gc->channels * sizeof(float));
+        return;
+    }
+    for (b = 0; b < GOLDEN_FRAMES / GOLDEN_BLOCK; b++) {
+        if (b == GOLDEN_FRAMES / GOLDEN_BLOCK / 4) {
+            params.shape = GOLDEN_SHAPE;
+        }
+        if (b == GOLDEN_FRAMES / GOLDEN_BLOCK / 2) {
+            params.topology = BQ_TDF2;
+        }
+        re_render_params(engine, &params, out + b * GOLDEN_BLOCK * gc->channels, GOLDEN_BLOCK);
+    }
+    re_destroy(engine);
+}
+
+//-----------------------------------------------------------------------------
+// Name: golden_path( )
+// Desc: file holding the reference render of a case
+//-----------------------------------------------------------------------------
+static void golden_path(char *path, size_t size, const char *dir, int which) {
+    snprintf(path, size, "%s/%s.f32", dir, g_golden[which].name);
+}
+
+//-----------------------------------------------------------------------------
+// Name: write_golden( )
+// Desc: stores the current renders as the new references, raw 32-bit floats
+//-----------------------------------------------------------------------------
+static int write_golden(const char *dir, float *buffer) {
+    char path[256];
+    wav_writer *wav;
+    int which, written;
+
+    for (which = 0; which < GOLDEN_COUNT; which++) {
+        golden_path(path, sizeof(path), dir, which);
+        render_golden(which, buffer);
+        wav = wav_open(path, RAW_FLOAT32, g_golden[which].channels, SAMPLE_RATE);
+        if (wav == NULL) {
+            fprintf(stderr, "Error: can't write %s\n", path);
+            return 0;
+        }
+        written = wav_write(wav, buffer, GOLDEN_FRAMES);
+        if (!wav_close(wav) || !written) {
+            fprintf(stderr, "Error: can't write %s\n", path);
+            return 0;
+        }
+        fprintf(g_text, "wrote %s\n", path);
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Name: check_golden( )
+// Desc: renders every case again and compares it with its reference,
+//       returns the number of failures. The SNR counts the difference as
+//       noise, so bit-exact output reads "exact"
+//-----------------------------------------------------------------------------
+static int check_golden(const char *dir, float *buffer, float *reference) {
+    char path[256];
+    int which, failures = 0;
+
+    fprintf(g_text, "\ngolden renders (%s)\n", dir);
+    fprintf(g_text, "%-14s %12s %12s %14s %8s\n", "case", "SNR (dB)", "min (dB)",
+            "max |diff|", "result");
+
+    for (which = 0; which < GOLDEN_COUNT; which++) {
+        size_t samples = (size_t)GOLDEN_FRAMES * g_golden[which].channels;
+        double signal = 0, noise = 0, snr;
+        FILE *file;
+        size_t i, got = 0;
+
+        golden_path(path, sizeof(path), dir, which);
+        file = fopen(path, "rb");
+        if (file != NULL) {
+            got = fread(reference, sizeof(float), samples, file);
+            fclose(file);
+        }
+        if (got != samples) {
+            fprintf(g_text, "%-14s %12s %12.0f %14s %8s\n", g_golden[which].name, "-",
+                    g_golden[which].min_snr, "-", "MISSING");
+            failures++;
+            continue;
+        }
+
+        render_golden(which, buffer);
+        for (i = 0; i < samples; i++) {
+            double error = buffer[i] - reference[i];
+            signal += (double)reference[i] * reference[i];
+            noise += error * error;
+        }
+        snr = (noise == 0) ? INFINITY : 10. * log10(signal / noise);
+
+        if (snr == INFINITY) {
+            fprintf(g_text, "%-14s %12s", g_golden[which].name, "exact");
+        } else {
+            fprintf(g_text, "%-14s %12.1f", g_golden[which].name, snr);
+        }
+        fprintf(g_text, " %12.0f %14g %8s\n", g_golden[which].min_snr,
+                max_difference(buffer, reference, samples),
+                snr >= g_golden[which].min_snr ? "ok" : "FAIL");
+        failures += (snr < g_golden[which].min_snr);
+    }
+    return failures;
+}
+
+//-----------------------------------------------------------------------------
+// Name: check_aliasing( )
+// Desc: each waveform's alias_floor against its limit. Returns the number
+//       of waveforms above their limit
+//-----------------------------------------------------------------------------
+static int check_aliasing(void) {
+    static const char *names[] = { "sine", "tri", "saw", "square" };
+    static const double limits[] = { ALIAS_LIMIT_SINE, ALIAS_LIMIT_TRI,
+        ALIAS_LIMIT_SAW, ALIAS_LIMIT_SQUARE };
+    float *buffer = (float*)malloc(ALIAS_SIZE * sizeof(float));
+    fft *f = fft_new(ALIAS_SIZE);
+    int waveform, failures = 0;
+    oscillator osc;
+
+    if (buffer == NULL || f == NULL) {
+        fprintf(stderr, "Error while allocating memory for the aliasing check\n");
+        free(buffer);
+        return 1;
+    }
+
+    fprintf(g_text, "\naliasing floor at %.1f Hz (inharmonic power / harmonic power)\n",
+            (double)ALIAS_CYCLES * SAMPLE_RATE / ALIAS_SIZE);
+    fprintf(g_text, "%-14s %12s %14s %8s\n", "waveform", "floor (dB)", "limit (dB)", "result");
+
+    for (waveform = OSC_SINE; waveform <= OSC_SQUARE; waveform++) {
+        double floor_db;
+
+        //set the increment directly, a float frequency would not repeat exactly
+        osc_init(&osc, waveform, 1000.f, SAMPLE_RATE);
+        osc.increment = (double)ALIAS_CYCLES / ALIAS_SIZE;
+        osc_process_block(&osc, buffer, ALIAS_SIZE);
+        floor_db = alias_floor(f, buffer);
+
+        fprintf(g_text, "%-14s %12.1f %14.1f %8s\n", names[waveform], floor_db,
+                limits[waveform], floor_db <= limits[waveform] ? "ok" : "FAIL");
+        failures += (floor_db > limits[waveform]);
+    }
+
+    fft_destroy(f);
+    free(buffer);
+    return failures;
+}
+
+//-----------------------------------------------------------------------------
+// Name: tone_level( )
+// Desc: amplitude of a LIBM sine at frequency through a voice with the
+//       given cutoffs, least squares fitted after the filters settled
+//-----------------------------------------------------------------------------
+static double tone_level(float lowpass, float highpass, double frequency, float *buffer) {
+    voice_pool *pool = vp_new(1, 1, GOLDEN_BLOCK, SAMPLE_RATE, BUTTERWORTH_Q);
+    double cc = 0, ss = 0, cs = 0, xc = 0, xs = 0, det, a, b;
+    int i;
+
+    if (pool == NULL) {
+        return 0;
+    }
+    vp_set_cutoffs(pool, lowpass, highpass, 0);
+    vp_note_on(pool, 1.f, .5f, 1.f, OSC_SINE, SINE_LIBM);
+    for (i = 0; i < TONE_SETTLE + TONE_FRAMES; i += GOLDEN_BLOCK) {
+        vp_render(pool, NULL, (float)frequency, 1.f,
+                buffer + (i < TONE_SETTLE ? 0 : i - TONE_SETTLE), GOLDEN_BLOCK);
+    }
+    vp_destroy(pool);
+
+    //the window holds no whole number of cycles, so solve for both phases
+    for (i = 0; i < TONE_FRAMES; i++) {
+        double angle = 2. * PI * frequency * (TONE_SETTLE + i) / SAMPLE_RATE;
+        double c = cos(angle), s = sin(angle);
+        cc += c * c;
+        ss += s * s;
+        cs += c * s;
+        xc += buffer[i] * c;
+        xs += buffer[i] * s;
+    }
+    det = cc * ss - cs * cs;
+    a = (xc * ss - xs * cs) / det;
+    b = (xs * cc - xc * cs) / det;
+    return sqrt(a * a + b * b);
+}
+
+//-----------------------------------------------------------------------------
+// Name: check_coefficient_table( )
+// Desc: the table of every filter type may be at most TABLE_MARGIN dB
+//       less accurate than the float formulas it replaces, in both bands.
+//       Returns the number of types that are not
+//-----------------------------------------------------------------------------
+static int check_coefficient_table(void) {
+    double errors[2][2];
+    int type, band, failures = 0;
+
+    fprintf(g_text, "\ncoefficient table against the float formulas\n");
+    for (type = LOWPASS; type <= HIGHSHELF; type++) {
+        int ok = table_errors(type, errors);
+
+        for (band = 0; ok && band < 2; band++) {
+            ok = errors[band][0] <= errors[band][1] + TABLE_MARGIN;
+        }
+        fprintf(g_text, "%-12s %8.1f %8.1f dB  %s\n", g_type_names[type],
+                errors[0][0], errors[1][0], ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+    return failures;
+}
+
+//-----------------------------------------------------------------------------
+// Name: check_cutoffs( )
+// Desc: finds the -3 dB point of the voice lowpass by bisection and
+//       compares it with the requested lowpass_freq. With a Butterworth Q
+//       the two are the same frequency. Returns the number of misses
+//-----------------------------------------------------------------------------
+static int check_cutoffs(float *buffer) {
+    static const float requested[] = { 250.f, 1000.f, 4000.f, 12000.f };
+    double open = tone_level(SAMPLE_RATE * .45f, 5.f, 1000., buffer);
+    double low, high, middle = 0, error;
+    int c, i, failures = 0;
+
+    fprintf(g_text, "\nlowpass -3 dB point (Q %.4f, pass within %.1f %%)\n",
+            BUTTERWORTH_Q, CUTOFF_TOLERANCE * 100.);
+    fprintf(g_text, "%-14s %12s %14s %8s\n", "requested Hz", "measured Hz", "error (%)", "result");
+
+    for (c = 0; c < 4; c++) {
+        low = requested[c] * .5;
+        high = requested[c] * 1.5;
+        for (i = 0; i < 24; i++) {
+            middle = (low + high) * .5;
+            if (tone_level(requested[c], 5.f, middle, buffer) / open > M_SQRT1_2) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        error = (middle / requested[c] - 1.) * 100.;
+
+        fprintf(g_text, "%-14.0f %12.1f %14.3f %8s\n", requested[c], middle, error,
+                fabs(error) <= CUTOFF_TOLERANCE * 100. ? "ok" : "FAIL");
+        failures += (fabs(error) > CUTOFF_TOLERANCE * 100.);
+    }
+    return failures;
+}
+
+//-----------------------------------------------------------------------------
+// Name: check_filter_graph( )
+// Desc: a full graph swept up from a low base frequency, gliding over
+//       GRAPH_STEP frames across the block boundaries, must give the
+//       output of the same stages chained with bq_process. Returns 1 if
+//       it does not
+//-----------------------------------------------------------------------------
+static int check_filter_graph(float *buffer, float *reference) {
+    static filter_graph fg;
+    biquad chain[GRAPH_CHANNELS][FG_MAX_STAGES];
+    oscillator osc;
+    float base = 100.f;
+    double difference;
+    int done, n, i, c, s;
+
+    osc_init(&osc, OSC_SAW, 220.f, SAMPLE_RATE);
+    osc_process_block(&osc, buffer, GOLDEN_FRAMES * GRAPH_CHANNELS);
+    build_graph(&fg, chain, FG_MAX_STAGES, GRAPH_CHANNELS);
+
+    //blocks split where the base moves, both retune there
+    for (done = 0; done < GOLDEN_FRAMES; done += n) {
+        n = GRAPH_STEP - done % GRAPH_STEP;
+        if (n > GOLDEN_BLOCK - done % GOLDEN_BLOCK) {
+            n = GOLDEN_BLOCK - done % GOLDEN_BLOCK;
+        }
+        if (done % GRAPH_STEP == 0) {
+            base *= 1.25f;
+            fg_set_base(&fg, base, GRAPH_STEP);
+            follow_graph(&fg, chain, GRAPH_STEP);
+        }
+        for (i = done; i < done + n; i++) {
+            for (c = 0; c < GRAPH_CHANNELS; c++) {
+                float x = buffer[i * GRAPH_CHANNELS + c];
+                for (s = 0; s < FG_MAX_STAGES; s++) {
+                    x = bq_process(&chain[c][s], x);
+                }
+                reference[i * GRAPH_CHANNELS + c] = x;
+            }
+        }
+        fg_process(&fg, buffer + done * GRAPH_CHANNELS, buffer + done * GRAPH_CHANNELS, n);
+    }
+    difference = max_difference(reference, buffer, GOLDEN_FRAMES * GRAPH_CHANNELS);
+
+    fprintf(g_text, "\nfilter graph against chained bq_process\n");
+    fprintf(g_text, "%d stages, %d channels: max |diff| %g  %s\n", FG_MAX_STAGES,
+            GRAPH_CHANNELS, difference, difference <= GRAPH_TOLERANCE ? "ok" : "FAIL");
+    return difference > GRAPH_TOLERANCE;
+}
+
+//-----------------------------------------------------------------------------
+// Name: run_checks( )
+// Desc: golden renders, aliasing floor and cutoff accuracy, returns the
+//       number of failed checks
+//-----------------------------------------------------------------------------
+static int run_checks(const char *dir) {
+    float *buffer = (float*)malloc(GOLDEN_FRAMES * 2 * sizeof(float));
+    float *reference = (float*)malloc(GOLDEN_FRAMES * 2 * sizeof(float));
+    int failures;
+
+    if (buffer == NULL || reference == NULL) {
+        fprintf(stderr, "Error while allocating memory for the checks\n");
+        free(buffer);
+        free(reference);
+        return 1;
+    }
+
+    failures = check_golden(dir, buffer, reference);
+    failures += check_aliasing();
+    failures += check_cutoffs(buffer);
+    failures += check_coefficient_table();
+    failures += check_filter_graph(buffer, reference);
+    fprintf(g_text, "\n%d check(s) failed\n", failures);
+
+    free(buffer);
+    free(reference);
+    return failures;
+}
+
+//-----------------------------------------------------------------------------
+// Name: main
+// Desc: runs every benchmark, --json adds the machine-readable results.
+//       --check only runs the checks and fails if one does, --golden
+//       first replaces the references with the current renders
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+    float *buffer = (float*)malloc(THD_SAMPLES * sizeof(float));
+    int json = 0, check = 0, golden = 0, i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = 1;
+        } else if (strcmp(argv[i], "--golden") == 0) {
+            golden = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--check] [--golden]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    g_text = json ? stderr : stdout;
+
+    if (buffer == NULL) {
+        fprintf(stderr, "Error while allocating memory for the benchmark");
+        return EXIT_FAILURE;
+    }
+
+    //THD_SAMPLES is enough for a stereo golden render
+    if (golden && !write_golden(GOLDEN_DIR, buffer)) {
+        free(buffer);
+        return EXIT_FAILURE;
+    }
+    if (check || golden) {
+        int failures = run_checks(GOLDEN_DIR);
+        free(buffer);
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    bench_sine(buffer);
+    bench_waveforms(buffer);
+    bench_wavetable();
+    bench_exp2();
+    bench_coefficients();
+    bench_coefficient_table();
+    bench_biquad();
+    bench_filter_graph();
+    bench_topologies();
+    bench_voices();
+    bench_threads();
+    bench_render();
+    bench_fft();
+
+    if (json) {
+        print_json();
+    }
+
+    free(buffer);
+    return EXIT_SUCCESS;
+}
@@ -26,16 +26,23 @@
 #include <string.h>
 #include <portaudio.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
 #include <SOIL/SOIL.h>
-#include "Biquad.h"
+#include "RiserEngine.h"
+#include "ParamChannel.h"
+#include "BlockRing.h"
+#include "Oscillator.h"
+#include "WavWriter.h"
+#include "FFT.h"
+#include "Graphics.h"
+#include "Automation.h"
+#include "PitchMap.h"
+#include "LoadMeter.h"
 
 // OpenGL
-#ifdef __MACOSX_CORE__
-#include <GLUT/glut.h>
-#else
-#include <GL/gl.h>
+#ifndef __MACOSX_CORE__
 #include <GL/glu.h>
-#include <GL/glut.h>
 #endif
 
 // Platform-dependent sleep routines.
@@ -53,24 +60,50 @@
 //-----------------------------------------------------------------------------
 #define INIT_FREQUENCY          220 //defines inital frequency
 #define INIT_VOLUME             1 //defines initial amplitude
-#define SINE                    0
-#define TRI                     1
-#define SAW                     2
-#define SQUARE                  3
+#define SINE                    OSC_SINE
+#define TRI                     OSC_TRI
+#define SAW                     OSC_SAW
+#define SQUARE                  OSC_SQUARE
 #define FORMAT                  paFloat32
-#define BUFFER_SIZE             1024
+#define BUFFER_SIZE             1024 //default frames per callback (--block)
+#define MIN_BLOCK               16
+#define MAX_BLOCK               4096
+#define AUTO_BLOCK_START        32 //smallest block --block auto tries
+#define PROBE_TIME              500 //ms each --block auto candidate plays
 #define SAMPLE                  float
-#define SAMPLE_RATE             44100
+#define SAMPLE_RATE             44100 //default sample rate (--rate)
+#define MIN_RATE                8000
+#define MAX_RATE                192000
+#define DISPLAY_SIZE            1024 //samples per waveform and spectrum frame
 #define MONO                    1
 #define STEREO                  2
-#define cmp_abs(x)              ( sqrt( (x).re * (x).re + (x).im * (x).im ) )
+#define MAX_CHANNELS            32 //upper limit for --channels
+#define INIT_VOICES             16 //size of the voice pool
 #define INIT_WIDTH              800 //defines initial window width
 #define INIT_HEIGHT             600 //defines inital window height
 #define PI                      3.14159265358979323846 //defines PI 3.14159265358979323846
 #define ROTATION_INCR           .75f //defines how fast the rotation happens
-#define RISE_INCR               .1f //Rise speed
+#define ROTATION_RATE           6.0 //degrees per second per unit of circle offset
+#define RISE_TIME               2.0 //seconds the auto rise takes (--rise-time)
+#define INIT_BPM                120 //tempo for --rise-beats
+#define INIT_FPS                60 //frame rate cap (--fps), 0 redraws whenever idle
+#define MAX_FPS                 1000
+#define MAX_FRAME_DT            .1 //longest step the animation takes at once
+#define HEADLESS_TICK           20 //ms between parameter updates without a window
 #define MIN_VOLUME              -160
-#define WATERFALL_SIZE          20
+#define PITCH_OCTAVES           3 //pad height in octaves above INIT_FREQUENCY
+#define CUTOFF_BOTTOM           27.5 //lowpass at the left edge of the pad
+#define CUTOFF_TOP              (INIT_FREQUENCY*8.0) //lowpass at the right edge
+#define WATERFALL_SIZE          20 //default history depth (--waterfall)
+#define MAX_WATERFALL           4096 //upper limit for the history depth
+#define WATERFALL_SPAN          2000 //z distance covered by the whole history
+#define SPECTRUM_FLOOR          -100 //dB drawn at the bottom of the waterfall
+#define SPECTRUM_SCALE          .05f //waterfall height per dB
+#define SPECTRUM_RANGE          100 //dB above the floor mapped onto the colormap
+#define CIRCLE_POINTS           300 //points on the circle outline
+#define RING_SLOTS              4 //output blocks kept for the renderer
+#define STATS_INTERVAL          5 //seconds between console load reports (--stats), 0 is off
+#define OVERLAY_REFRESH         .5 //seconds between load overlay updates
 #define X_MIN                   -6.12
 #define Y_MIN                   -3.64
 #define X_MAX                   6.12
@@ -80,16 +113,10 @@
 // Name: GLOBAL VARIABLES
 //-----------------------------------------------------------------------------
 
-//structure for portaudio callback function
+//parameters edited by the GUI, published to the engine
 typedef struct {
-    float frequency;
-    int amplitude;
-    int wavetype;
-
-    float lowpass_freq;
-    float highpass_freq;
-
-    float wave_buff[BUFFER_SIZE];
+    //working copy of the parameters, only touched by the GUI thread
+    riser_params params;
 } paData;
 
 //struct for positions
@@ -107,12 +134,36 @@ typedef struct {
 //initialize global data
 paData data; 
 
-//initializes filters
-biquad* bq_low;
-biquad* bq_high;
-
-//initialize waterfall matrix
-float g_waterfall[WATERFALL_SIZE][BUFFER_SIZE];
+//synthesis core rendered by the audio callback, allocated once in
+//init_engine(); the voice stacks selectable with 'v' live in it
+riser_engine *g_engine;
+int g_voice_count = INIT_VOICES;
+
+//worker threads that help the audio callback render voices (--threads)
+int g_worker_count = 0;
+
+//waterfall history, a ring of g_waterfall_depth rows of g_waterfall_width
+//dB magnitudes. g_waterfall_head is the newest row, pushing a row only
+//moves the head.
+float *g_waterfall;
+int g_waterfall_depth = WATERFALL_SIZE;
+int g_waterfall_width = DISPLAY_SIZE / 2;
+int g_waterfall_head = 0;
+
+//GPU side of the display, built in initialize_graphics() once the window
+//exists. The waterfall rows are mirrored into gfx_waterfall as they are
+//pushed, so drawing the history uploads nothing.
+gfx_trace *g_gfx_trace;
+gfx_circle *g_gfx_circle;
+gfx_waterfall *g_gfx_waterfall;
+gfx_spectrogram *g_gfx_spectrogram;
+
+//draw the waterfall as a colormapped texture instead of lines ('t')
+bool g_spectrogram = false;
+
+//spectrum analyser, runs in displayFunc on the newest output block
+fft *g_fft;
+float g_spectrum[DISPLAY_SIZE / 2];
 
 typedef double  MY_TYPE;
 typedef char BYTE;   // 8-bit unsigned entity.
@@ -123,18 +174,35 @@ GLsizei g_height = INIT_HEIGHT;
 GLsizei g_last_width = INIT_WIDTH;
 GLsizei g_last_height = INIT_HEIGHT;
 
-// global audio vars
-GLint g_buffer_size = BUFFER_SIZE;
+// global audio vars, --rate, --block and --latency. A latency of 0 asks
+// for the device's default low latency.
+int g_sample_rate = SAMPLE_RATE;
+int g_block_size = BUFFER_SIZE;
+bool g_auto_block = false;
+double g_latency = 0.;
 
-//buffer for wave graphics
-SAMPLE g_buffer[BUFFER_SIZE * 2];
+//callback timing, DSP load and underflows, recorded by the audio thread
+load_meter g_meter;
+double g_stats_interval = STATS_INTERVAL;
+bool g_show_stats = true; //load overlay ('i')
+load_report g_overlay_report;
 
-//window buffer
-SAMPLE g_window[BUFFER_SIZE]; 
-unsigned int g_channels = MONO;
+// display length, independent of the block size
+GLint g_buffer_size = DISPLAY_SIZE;
+
+//buffer for wave graphics, newest block taken from g_ring
+SAMPLE g_buffer[DISPLAY_SIZE];
 
-// Threads Management
-GLboolean g_ready = false;
+//output blocks handed from the audio thread to the renderer, the callback
+//collects g_buffer_size samples into a slot before publishing it
+block_ring *g_ring;
+float *g_display_slot = NULL;
+int g_display_fill = 0;
+
+//window buffer
+SAMPLE g_window[DISPLAY_SIZE]; 
+float g_window_gain = 1.f; //coherent gain of g_window, 0 dB = full scale sine
+unsigned int g_channels = STEREO;
 
 // fill mode
 GLenum g_fillmode = GL_FILL;
@@ -171,14 +239,48 @@ bool g_key_rotate_y = false;
 GLfloat g_inc_y = 0.0;
 GLfloat g_inc_x = 0.0;
 
-//self riser
+//exponential pad axes, pitch bottom to top and lowpass left to right
+pitch_map g_pitch_map;
+pitch_map g_cutoff_map;
+
+//self riser, the pitch and cutoffs are automated on the audio thread and
+//the circle follows them
 bool self_rise = false;
+double g_rise_seconds = RISE_TIME;
+int g_rise_curve = AU_LINEAR;
+
+//waveform, voice stack, filter topology and filter shape to start with
+//(--wave, --stack, --filter, --shape)
+int g_init_wavetype = SINE;
+int g_init_stack = 0;
+int g_init_topology = BQ_DF1;
+int g_init_shape = 0;
+
+// Frame pacing, frames are scheduled with glutTimerFunc so the main thread
+// sleeps between them. Animation advances by g_frame_dt seconds per frame.
+int g_frame_rate = INIT_FPS;
+double g_next_frame = 0.;
+double g_last_frame = 0.;
+double g_frame_dt = 0.;
+
+// Playing without a window (--headless), the main thread only wakes up to
+// move the circle
+bool g_headless = false;
+
+// Offline rendering (--render), no audio device and no window
+const char *g_render_path = NULL;
+double g_render_duration = 8.0; //seconds
+int g_render_format = WAV_FLOAT32;
+bool g_render_rise = false;
+Pos g_render_pad = {0., 0.}; //pad position for renders without --rise, 0..1
 
 //-----------------------------------------------------------------------------
 // function prototypes
 //-----------------------------------------------------------------------------
 void help();
 void idleFunc( );
+void frameTimer( int value );
+void schedule_frame( );
 void displayFunc( );
 void reshapeFunc( int width, int height );
 void keyboardFunc( unsigned char, int, int );
@@ -188,12 +290,30 @@ void initialize_glut(int argc, char *argv[]);
 void mouseFunc(int button, int state, int x, int y);
 void mouseMotionFunc(int x, int y);
 void initialize_audio(PaStream **g_stream);
+PaError open_stream(PaStream **stream, unsigned long frames);
+PaError probe_block_size(PaStream **stream);
+void feed_display(const float *out, unsigned long frames);
+void update_stats(double now);
+void drawStats();
 void stop_portAudio(PaStream **g_stream);
 void init_datastruct();
+void parse_args(int argc, char *argv[]);
+void position_to_params(double x, double y, riser_params *params);
+int render_offline();
+double now_seconds();
+void init_engine();
+void publish_params();
 void hanning( float * window, unsigned long length );
+void init_waterfall();
+void push_waterfall(const float *spectrum, int bins);
 void riser ();
+void start_rise(double seconds);
+void stop_rise();
+void fill_rise(riser_automation *rise, double x, double y, double seconds);
+void params_to_position(double frequency, double lowpass_freq, Pos *pos);
+void update_circle();
+int run_headless();
 void drawWindowedTimeDomain( float , SAMPLE *buffer);
-double round(double);
 
 // Function copied from the FFT library
 void apply_window( float * data, float * window, unsigned long length )
@@ -219,7 +339,14 @@ void help()
     printf( "click and drag mouse left and right - change lowpass frequency\n" );
     printf( "'spacebar' - automatically move circle to top right corner\n" );
     printf( "'s' - bring circle back to bottom left corner \n" );
-    printf( "'w' - change waveform");
+    printf( "'c' - change rise curve (linear, exponential, log frequency, s-curve)\n");
+    printf( "'w' - change waveform\n");
+    printf( "'n' - change sine implementation (libm, table, polynomial, quadrature)\n");
+    printf( "'v' - change voice stack (single, detuned, chord, octaves)\n");
+    printf( "'b' - change filter topology (direct form I, transposed II, transposed II double, state variable)\n");
+    printf( "'g' - change filter shape (12 dB, 24 dB, 48 dB, formant, shelved)\n");
+    printf( "'t' - change waterfall look (lines, spectrogram)\n");
+    printf( "'i' - show or hide the DSP load overlay\n");
     printf( "'m' - mute audio\n" );
     printf( "'arrow keys' - turn on green waveform movement\n");
     printf( "'q' - quit\n" );
@@ -237,155 +364,46 @@ static int paCallback( const void *inputBuffer,
         const PaStreamCallbackTimeInfo* timeInfo,
         PaStreamCallbackFlags statusFlags, void *userData ) {
     
+    unsigned long long start = lm_now_ns();
+
     float *out = (float*)outputBuffer; //casting the output buffer to a float
-    
-    //starts the samples at -1
-    static float sine_sample = -1; 
-    static float triangle_sample = -1;
-    static float saw_sample = -1;
-    
-    //phase for sinewave
-    float sine_phase;
-    
-    //left previous phase holder starting at 0
-    static float prev_phase = 0; 
-    
-    //false is left side of triangle, true is right
-    bool triangle_side = false; 
-    
-    //phase for squarewave
-    static int square_phase = 0;
-    
-    int period = SAMPLE_RATE/data.frequency;
-    int amplitude = data.amplitude; //local variable for amplitude
+    riser_engine *engine = (riser_engine*)userData;
 
-    int i;
-    
-    //initiate the highpass and lowpass buffers
-    bq_low = bq_new(LOWPASS,data.lowpass_freq,10.0,1.0,SAMPLE_RATE);
-    bq_high = bq_new(HIGHPASS,data.highpass_freq*1.2,10.0,1.0,SAMPLE_RATE);
-
-
-    for (i = 0; i < framesPerBuffer; i++){ 
-        //tests for cases of what type of waveform
-        switch(data.wavetype){
-            
-            case SINE:
-//*****************************************************************SINE********************************************************
-                sine_phase = 2. * PI * data.frequency / SAMPLE_RATE + prev_phase; //gets phase of sinewave
-                sine_sample = sin(sine_phase);
-        
-                data.wave_buff[2 * i] = (sine_sample * amplitude); //wave_buffput left times the amplification
-                data.wave_buff[2 * i + 1] = (sine_sample * amplitude); //wave_buffput right times the amplification
-                
-                //set the output going through the lowpass and highpass filters
-                out[2*i] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i])));        
-                out[2*i+1] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i+1])));
-                
-                //input the g_buffer with the output buffer
-                g_buffer[2*i] = out[2*i];
-                g_buffer[2*i+1] = out[2*i+1];
-
-
-                if(sine_phase > 2. * PI){ //restart the phase of sine wave
-                    sine_phase -= 2. * PI; 
-                }
+    //voices and filters with the newest parameter set
+    re_render(engine, out, framesPerBuffer);
 
-                prev_phase = sine_phase; //sets previous phase
-                break;
-    
-            case TRI:
-//*****************************************************************TRIANGLE**************************************************
-                if(triangle_side == false){//going up on triangle
-                    triangle_sample += 2. / (period/2);
-            
-                    if(triangle_sample > 1.){//put so that the triangle would not clip
-                        triangle_sample = 1.;
-                    }
-                }
+    //the first channel goes to the renderer
+    feed_display(out, framesPerBuffer);
 
-                if(triangle_side == true){//going down on triangle
-                    triangle_sample -= 2. / (period/2);
-            
-                    if(triangle_sample < -1.){
-                        triangle_sample = -1.;
-                    }
-                }
-        
-                data.wave_buff[2 * i] = triangle_sample * amplitude;
-                data.wave_buff[2 * i + 1] = triangle_sample * amplitude;
-                
-                //set the output going through the lowpass and highpass filters
-                out[2*i] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i])));        
-                out[2*i+1] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i+1])));
-                
-                //input the g_buffer with the output buffer
-                g_buffer[2*i] = out[2*i];
-                g_buffer[2*i+1] = out[2*i+1];
-
-
-                //sets the sides of the triangle
-                if(triangle_sample >= 1. || triangle_sample <= -1.){ 
-                    triangle_side = !triangle_side;
-                }
-                break;
-                        
-            case SAW:
-//*****************************************************************SAW*******************************************************
-                saw_sample += 2. / period;//saw only goes up and then drops off for its period
-            
-                if(saw_sample > 1){
-                    saw_sample -= 2;
-                }
-        
-                data.wave_buff[2 * i] = saw_sample * amplitude;
-                data.wave_buff[2 * i + 1] = saw_sample * amplitude;
-                
-                //set the output going through the lowpass and highpass filters
-                out[2*i] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i])));        
-                out[2*i+1] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i+1])));
-                
-                //input the g_buffer with the output buffer
-                g_buffer[2*i] = out[2*i];
-                g_buffer[2*i+1] = out[2*i+1];
-    
-                break;
-
-            case SQUARE:
-//*****************************************************************SQUARE*****************************************************
-                // Assign wave_buffput
-                if (square_phase < period/2) {
-                    data.wave_buff[2*i] = amplitude;  /* left */
-                    data.wave_buff[2*i+1] = amplitude;  /* right */    
-                }
-                else if (square_phase >= period/2) {
-                    data.wave_buff[2*i] = -amplitude;  /* left */
-                    data.wave_buff[2*i+1] = -amplitude;  /* right */    
-                }
-                
-                //set the output going through the lowpass and highpass filters
-                out[2*i] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i])));        
-                out[2*i+1] = bq_process(bq_high, (bq_process(bq_low, data.wave_buff[2*i+1])));
-                
-                //input the g_buffer with the output buffer
-                g_buffer[2*i] = out[2*i];
-                g_buffer[2*i+1] = out[2*i+1];
-
-                // Increase phase
-                square_phase++;
-
-                // Wrap phase
-                if (square_phase >= period) {
-                    square_phase = 0;
-                }
-            } 
-        }
-     
-    // set flag
-    g_ready = true;
+    //time against the block period, and underflows PortAudio reported
+    lm_record(&g_meter, start, framesPerBuffer, g_sample_rate,
+            (statusFlags & paOutputUnderflow) != 0);
     return paContinue; //return 
 
 }
+
+//-----------------------------------------------------------------------------
+// Name: feed_display( )
+// Desc: Appends the first channel of frames interleaved frames to the
+//       display slot and publishes it to the renderer once it holds
+//       g_buffer_size samples, whatever the block size is
+//-----------------------------------------------------------------------------
+void feed_display(const float *out, unsigned long frames) {
+    unsigned long i;
+
+    for (i = 0; i < frames; i++){
+        if (g_display_slot == NULL){
+            g_display_slot = br_begin_write(g_ring);
+        }
+        g_display_slot[g_display_fill++] = out[i * g_channels];
+        if (g_display_fill == g_buffer_size){
+            // hand the block to the renderer
+            br_end_write(g_ring);
+            g_display_slot = NULL;
+            g_display_fill = 0;
+        }
+    }
+}
 //-----------------------------------------------------------------------------
 // Name: init_datastruct( )
 // Desc: Initializes parameters in the data structure
@@ -393,9 +411,10 @@ static int paCallback( const void *inputBuffer,
 void init_datastruct(void) {
 
     //set initial parameters of wave for frequency and amplitude
-    data.frequency = INIT_FREQUENCY;
-    data.amplitude = INIT_VOLUME;
-    data.wavetype = SINE;
+    data.params.frequency = INIT_FREQUENCY;
+    data.params.amplitude = INIT_VOLUME;
+    data.params.wavetype = g_init_wavetype;
+    data.params.sine_mode = SINE_TABLE;
     
     //set the position of the circle
     g_circle.center.x = X_MIN;
@@ -404,8 +423,42 @@ void init_datastruct(void) {
     g_circle.coord.y = 0;
 
     /* Init lowpass and highpass */
-    data.lowpass_freq = 0;
-    data.highpass_freq = 0;
+    data.params.lowpass_freq = 0;
+    data.params.highpass_freq = 0;
+
+    /* Init voice stack, filter topology and filter shape */
+    data.params.stack = g_init_stack;
+    data.params.topology = g_init_topology;
+    data.params.shape = g_init_shape;
+
+    /* Pad axes, builds the exp2 table before the audio thread starts */
+    pm_init(&g_pitch_map, INIT_FREQUENCY, INIT_FREQUENCY * pow(2, PITCH_OCTAVES));
+    pm_init(&g_cutoff_map, CUTOFF_BOTTOM, CUTOFF_TOP);
+
+    /* No rise running */
+    memset(&data.params.automation, 0, sizeof(data.params.automation));
+}
+
+//-----------------------------------------------------------------------------
+// Name: publish_params( )
+// Desc: Hands the GUI's working copy of the parameters to the audio thread
+//-----------------------------------------------------------------------------
+void publish_params(void) {
+    re_set_params(g_engine, &data.params);
+}
+
+//-----------------------------------------------------------------------------
+// Name: init_engine( )
+// Desc: Allocates the voices, filters and helper threads before the stream
+//       starts, so the audio callback never mallocs. With --block auto the
+//       engine takes the largest block that may be picked.
+//-----------------------------------------------------------------------------
+void init_engine(void) {
+    g_engine = re_new(g_voice_count, g_channels, g_block_size, g_sample_rate,
+            g_worker_count, &data.params);
+    if(g_engine == NULL){
+        exit(EXIT_FAILURE);
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -427,8 +480,11 @@ void initialize_glut(int argc, char *argv[]) {
     if( g_fullscreen )
         glutFullScreen();
 
-    // set the idle function - called when idle
-    glutIdleFunc( idleFunc );
+    // uncapped redraws whenever GLUT is idle, otherwise paced by a timer
+    if( g_frame_rate == 0 )
+        glutIdleFunc( idleFunc );
+    else
+        schedule_frame( );
     // set the display function - called when redrawing
     glutDisplayFunc( displayFunc );
     // set the reshape function - called when client area changes
@@ -465,40 +521,101 @@ void hanning( float * window, unsigned long length )
 }
 
 //-----------------------------------------------------------------------------
-// Name: initialize_audio( RtAudio *dac )
-// Desc: Initializes PortAudio with the global vars and the stream
+// Name: open_stream( )
+// Desc: Opens and starts an output stream with frames per callback at
+//       --rate and --latency
 //-----------------------------------------------------------------------------
-void initialize_audio(PaStream **g_stream) {
-    
+PaError open_stream(PaStream **stream, unsigned long frames) {
     PaStreamParameters outputParameters;
     PaError err;
 
-    /* Initialize PortAudio */
-    Pa_Initialize();
-
     /* Set output stream parameters */
     outputParameters.device = Pa_GetDefaultOutputDevice();
     outputParameters.channelCount = g_channels;
     outputParameters.sampleFormat = paFloat32;
-    outputParameters.suggestedLatency = 
+    outputParameters.suggestedLatency = g_latency > 0 ? g_latency :
         Pa_GetDeviceInfo( outputParameters.device )->defaultLowOutputLatency;
     outputParameters.hostApiSpecificStreamInfo = NULL;
 
     /* Open audio stream */
-    err = Pa_OpenStream( &(*g_stream),
+    err = Pa_OpenStream( stream,
             NULL,
             &outputParameters,
-            SAMPLE_RATE, BUFFER_SIZE, paNoFlag, 
-            paCallback, NULL );
+            g_sample_rate, frames, paNoFlag, 
+            paCallback, g_engine );
 
     if (err != paNoError) {
         printf("PortAudio error: open stream: %s\n", Pa_GetErrorText(err));
+        return err;
     }
 
     /* Start audio stream */
-    err = Pa_StartStream( *g_stream );
+    err = Pa_StartStream( *stream );
     if (err != paNoError) {
         printf(  "PortAudio error: start stream: %s\n", Pa_GetErrorText(err));
+        Pa_CloseStream( *stream );
+    }
+    return err;
+}
+
+//-----------------------------------------------------------------------------
+// Name: probe_block_size( )
+// Desc: Plays PROBE_TIME ms with growing block sizes, from AUTO_BLOCK_START
+//       up to --block, and keeps the first stream without underflows.
+//       Its block size goes to g_block_size. Returns the error of the
+//       last stream tried if none could be opened.
+//-----------------------------------------------------------------------------
+PaError probe_block_size(PaStream **stream) {
+    int frames;
+    unsigned int underflows;
+
+    for (frames = AUTO_BLOCK_START; frames < g_block_size; frames *= 2) {
+        if (open_stream(stream, frames) != paNoError) {
+            continue;
+        }
+        underflows = atomic_load(&g_meter.underflows);
+        SLEEP(PROBE_TIME);
+        underflows = atomic_load(&g_meter.underflows) - underflows;
+        printf("[RISER GENERATOR]: %d frames: %u underflows\n", frames, underflows);
+        if (underflows == 0) {
+            g_block_size = frames;
+            return paNoError;
+        }
+        Pa_StopStream( *stream );
+        Pa_CloseStream( *stream );
+    }
+
+    return open_stream(stream, g_block_size);
+}
+
+//-----------------------------------------------------------------------------
+// Name: initialize_audio( RtAudio *dac )
+// Desc: Initializes PortAudio with the global vars and the stream, and
+//       reports the rate and latency the device granted. The stream is
+//       left NULL if it could not be opened.
+//-----------------------------------------------------------------------------
+void initialize_audio(PaStream **g_stream) {
+    const PaStreamInfo *info;
+    PaError err;
+
+    /* Initialize PortAudio */
+    Pa_Initialize();
+
+    if (g_auto_block) {
+        err = probe_block_size(g_stream);
+    }
+    else {
+        err = open_stream(g_stream, g_block_size);
+    }
+    if (err != paNoError) {
+        *g_stream = NULL;
+        return;
+    }
+
+    info = Pa_GetStreamInfo( *g_stream );
+    if (info != NULL) {
+        printf("[RISER GENERATOR]: %.0f Hz, %d frames per block, output latency %.1f ms\n",
+                info->sampleRate, g_block_size, info->outputLatency * 1000.);
     }
 }
 
@@ -509,15 +626,16 @@ void initialize_audio(PaStream **g_stream) {
 void stop_portAudio(PaStream **g_stream) {
     PaError err;
 
-    /* Stop audio stream */
-    err = Pa_StopStream( *g_stream );
-    if (err != paNoError) {
-        printf(  "PortAudio error: stop stream: %s\n", Pa_GetErrorText(err));
-    }
-    /* Close audio stream */
-    err = Pa_CloseStream(*g_stream);
-    if (err != paNoError) {
-        printf("PortAudio error: close stream: %s\n", Pa_GetErrorText(err));
+    /* Stop and close the audio stream, if it ever opened */
+    if (*g_stream != NULL) {
+        err = Pa_StopStream( *g_stream );
+        if (err != paNoError) {
+            printf(  "PortAudio error: stop stream: %s\n", Pa_GetErrorText(err));
+        }
+        err = Pa_CloseStream(*g_stream);
+        if (err != paNoError) {
+            printf("PortAudio error: close stream: %s\n", Pa_GetErrorText(err));
+        }
     }
     /* Terminate audio stream */
     err = Pa_Terminate();
@@ -525,10 +643,354 @@ void stop_portAudio(PaStream **g_stream) {
         printf("PortAudio error: terminate: %s\n", Pa_GetErrorText(err));
     }
 
-    //terminate filter
-    bq_destroy(bq_low);
-    bq_destroy(bq_high);
+    //report how many parameter sets never reached the callback
+    re_print_info(g_engine);
+
+    //terminate voices
+    re_destroy(g_engine);
+
+    br_destroy(g_ring);
+    fft_destroy(g_fft);
+    free(g_waterfall);
+
+    gfx_trace_destroy(g_gfx_trace);
+    gfx_circle_destroy(g_gfx_circle);
+    gfx_waterfall_destroy(g_gfx_waterfall);
+    gfx_spectrogram_destroy(g_gfx_spectrogram);
+
+}
+
+//-----------------------------------------------------------------------------
+// Name: parse_args( )
+// Desc: Reads the command line options, everything unknown is left to GLUT
+//-----------------------------------------------------------------------------
+void parse_args(int argc, char *argv[]) {
+    int i;
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--channels") == 0 && i + 1 < argc){
+            g_channels = atoi(argv[++i]);
+            if(g_channels < 1 || g_channels > MAX_CHANNELS){
+                printf("[RISER GENERATOR]: --channels must be between 1 and %d\n", MAX_CHANNELS);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--voices") == 0 && i + 1 < argc){
+            g_voice_count = atoi(argv[++i]);
+            if(g_voice_count < 1 || g_voice_count > VP_MAX_VOICES){
+                printf("[RISER GENERATOR]: --voices must be between 1 and %d\n", VP_MAX_VOICES);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            g_worker_count = atoi(argv[++i]);
+            if(g_worker_count < 0 || g_worker_count > JP_MAX_WORKERS){
+                printf("[RISER GENERATOR]: --threads must be between 0 and %d\n", JP_MAX_WORKERS);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--rate") == 0 && i + 1 < argc){
+            g_sample_rate = atoi(argv[++i]);
+            if(g_sample_rate < MIN_RATE || g_sample_rate > MAX_RATE){
+                printf("[RISER GENERATOR]: --rate must be between %d and %d\n", MIN_RATE, MAX_RATE);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--block") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "auto") == 0){
+                g_auto_block = true;
+            }
+            else{
+                g_block_size = atoi(argv[i]);
+                if(g_block_size < MIN_BLOCK || g_block_size > MAX_BLOCK){
+                    printf("[RISER GENERATOR]: --block must be auto or between %d and %d\n", MIN_BLOCK, MAX_BLOCK);
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else if(strcmp(argv[i], "--latency") == 0 && i + 1 < argc){
+            g_latency = atof(argv[++i]) / 1000.;
+            //also catches NaN and text that isn't a number
+            if(!(g_latency > 0)){
+                printf("[RISER GENERATOR]: --latency must be above 0 ms\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--stack") == 0 && i + 1 < argc){
+            g_init_stack = atoi(argv[++i]);
+            if(g_init_stack < 0 || g_init_stack >= re_stack_count){
+                printf("[RISER GENERATOR]: --stack must be between 0 and %d\n", re_stack_count - 1);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--shape") == 0 && i + 1 < argc){
+            g_init_shape = atoi(argv[++i]);
+            if(g_init_shape < 0 || g_init_shape >= re_shape_count){
+                printf("[RISER GENERATOR]: --shape must be between 0 and %d\n", re_shape_count - 1);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--render") == 0 && i + 1 < argc){
+            g_render_path = argv[++i];
+            //.raw files get headerless float samples
+            size_t length = strlen(g_render_path);
+            if(length > 4 && strcmp(g_render_path + length - 4, ".raw") == 0){
+                g_render_format = RAW_FLOAT32;
+            }
+        }
+        else if(strcmp(argv[i], "--duration") == 0 && i + 1 < argc){
+            g_render_duration = atof(argv[++i]);
+            //also catches NaN
+            if(!(g_render_duration > 0)){
+                printf("[RISER GENERATOR]: --duration must be above 0 seconds\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--rise") == 0){
+            g_render_rise = true;
+        }
+        else if(strcmp(argv[i], "--pad") == 0 && i + 2 < argc){
+            g_render_pad.x = atof(argv[++i]);
+            g_render_pad.y = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "float") == 0){
+                g_render_format = WAV_FLOAT32;
+            }
+            else if(strcmp(argv[i], "24") == 0){
+                g_render_format = WAV_PCM24;
+            }
+            else{
+                printf("[RISER GENERATOR]: --format must be float or 24\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--waterfall") == 0 && i + 2 < argc){
+            g_waterfall_depth = atoi(argv[++i]);
+            g_waterfall_width = atoi(argv[++i]);
+            if(g_waterfall_depth < 1 || g_waterfall_depth > MAX_WATERFALL){
+                printf("[RISER GENERATOR]: --waterfall depth must be between 1 and %d\n", MAX_WATERFALL);
+                exit(EXIT_FAILURE);
+            }
+            if(g_waterfall_width < 2 || g_waterfall_width > DISPLAY_SIZE / 2){
+                printf("[RISER GENERATOR]: --waterfall width must be between 2 and %d\n", DISPLAY_SIZE / 2);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--fps") == 0 && i + 1 < argc){
+            g_frame_rate = atoi(argv[++i]);
+            if(g_frame_rate < 0 || g_frame_rate > MAX_FPS){
+                printf("[RISER GENERATOR]: --fps must be between 0 and %d\n", MAX_FPS);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--rise-time") == 0 && i + 1 < argc){
+            g_rise_seconds = atof(argv[++i]);
+            //also catches NaN
+            if(!(g_rise_seconds >= 0)){
+                printf("[RISER GENERATOR]: --rise-time must be 0 seconds or more\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--rise-beats") == 0 && i + 2 < argc){
+            double beats = atof(argv[++i]);
+            double bpm = atof(argv[++i]);
+            if(!(bpm > 0)){
+                printf("[RISER GENERATOR]: --rise-beats needs a tempo above 0\n");
+                exit(EXIT_FAILURE);
+            }
+            if(!(beats >= 0)){
+                printf("[RISER GENERATOR]: --rise-beats needs 0 beats or more\n");
+                exit(EXIT_FAILURE);
+            }
+            g_rise_seconds = beats * 60. / bpm;
+        }
+        else if(strcmp(argv[i], "--curve") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "linear") == 0){
+                g_rise_curve = AU_LINEAR;
+            }
+            else if(strcmp(argv[i], "exp") == 0){
+                g_rise_curve = AU_EXPONENTIAL;
+            }
+            else if(strcmp(argv[i], "log") == 0){
+                g_rise_curve = AU_LOG_FREQ;
+            }
+            else if(strcmp(argv[i], "s") == 0){
+                g_rise_curve = AU_S_CURVE;
+            }
+            else{
+                printf("[RISER GENERATOR]: --curve must be linear, exp, log or s\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "df1") == 0){
+                g_init_topology = BQ_DF1;
+            }
+            else if(strcmp(argv[i], "tdf2") == 0){
+                g_init_topology = BQ_TDF2;
+            }
+            else if(strcmp(argv[i], "double") == 0){
+                g_init_topology = BQ_TDF2_DOUBLE;
+            }
+            else if(strcmp(argv[i], "svf") == 0){
+                g_init_topology = BQ_SVF;
+            }
+            else{
+                printf("[RISER GENERATOR]: --filter must be df1, tdf2, double or svf\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--stats") == 0 && i + 1 < argc){
+            char *end;
+            g_stats_interval = strtod(argv[++i], &end);
+            //0 turns the console report off, NaN and text are refused
+            if(end == argv[i] || !(g_stats_interval >= 0)){
+                printf("[RISER GENERATOR]: --stats must be 0 (off) or more seconds\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--headless") == 0){
+            g_headless = true;
+        }
+        else if(strcmp(argv[i], "--spectrogram") == 0){
+            g_spectrogram = true;
+        }
+        else if(strcmp(argv[i], "--wave") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "sine") == 0){
+                g_init_wavetype = SINE;
+            }
+            else if(strcmp(argv[i], "tri") == 0){
+                g_init_wavetype = TRI;
+            }
+            else if(strcmp(argv[i], "saw") == 0){
+                g_init_wavetype = SAW;
+            }
+            else if(strcmp(argv[i], "square") == 0){
+                g_init_wavetype = SQUARE;
+            }
+            else{
+                printf("[RISER GENERATOR]: --wave must be sine, tri, saw or square\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
 
+//-----------------------------------------------------------------------------
+// Name: now_seconds( )
+// Desc: monotonic clock in seconds
+//-----------------------------------------------------------------------------
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//-----------------------------------------------------------------------------
+// Name: render_offline( )
+// Desc: Renders --duration seconds through the engine into the
+//       --render file as fast as the CPU allows. With --rise the pitch and
+//       cutoffs are automated from the bottom left to the top right corner
+//       over the render, otherwise the pad stays at --pad.
+//-----------------------------------------------------------------------------
+int render_offline(void) {
+    unsigned long total = (unsigned long)(g_render_duration * g_sample_rate);
+    unsigned long done = 0;
+    riser_params params = data.params;
+    double start, elapsed;
+    load_snapshot before, after;
+    load_report report;
+    float *block;
+    wav_writer *wav;
+
+    block = (float*)malloc(g_block_size * g_channels * sizeof(float));
+    if(block == NULL){
+        printf("Error while allocating memory for the render buffer\n");
+        return EXIT_FAILURE;
+    }
+
+    wav = wav_open(g_render_path, g_render_format, g_channels, g_sample_rate);
+    if(wav == NULL){
+        free(block);
+        return EXIT_FAILURE;
+    }
+
+    position_to_params(X_MIN + g_render_pad.x * (X_MAX - X_MIN),
+            Y_MIN + g_render_pad.y * (Y_MAX - Y_MIN), &params);
+    if(g_render_rise){
+        fill_rise(&params.automation, X_MIN, Y_MIN, g_render_duration);
+    }
+
+    lm_snapshot(&g_meter, &before);
+    start = now_seconds();
+    while(done < total){
+        unsigned long frames = (total - done < (unsigned long)g_block_size)
+                ? total - done : (unsigned long)g_block_size;
+        unsigned long long block_start = lm_now_ns();
+
+        re_render_params(g_engine, &params, block, frames);
+        lm_record(&g_meter, block_start, frames, g_sample_rate, 0);
+
+        if(!wav_write(wav, block, frames)){
+            printf("[RISER GENERATOR]: error while writing %s\n", g_render_path);
+            wav_close(wav);
+            free(block);
+            return EXIT_FAILURE;
+        }
+        done += frames;
+    }
+    elapsed = now_seconds() - start;
+
+    free(block);
+    if(!wav_close(wav)){
+        printf("[RISER GENERATOR]: error while finishing %s\n", g_render_path);
+        return EXIT_FAILURE;
+    }
+
+    printf("[RISER GENERATOR]: rendered %.2f s to %s in %.3f s (%.1fx realtime)\n",
+            (double)total / g_sample_rate, g_render_path, elapsed,
+            elapsed > 0 ? (double)total / g_sample_rate / elapsed : 0.);
+
+    //the engine alone, against the time each block would last
+    lm_snapshot(&g_meter, &after);
+    lm_report(&before, &after, &report);
+    lm_print(&report);
+    return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+// Name: run_headless( )
+// Desc: Plays --duration seconds without a window. The circle starts at
+//       --pad and rises over --rise-time with --rise; the main thread
+//       sleeps HEADLESS_TICK ms between parameter updates.
+//-----------------------------------------------------------------------------
+int run_headless(void) {
+    double start;
+
+    g_circle.center.x = X_MIN + g_render_pad.x * (X_MAX - X_MIN);
+    g_circle.center.y = Y_MIN + g_render_pad.y * (Y_MAX - Y_MIN);
+    update_circle();
+    if(g_render_rise){
+        start_rise(g_rise_seconds);
+    }
+
+    initialize_audio(&g_stream);
+
+    start = now_seconds();
+    while(now_seconds() - start < g_render_duration){
+        riser();
+        update_circle();
+        update_stats(now_seconds());
+        SLEEP(HEADLESS_TICK);
+    }
+
+    stop_portAudio(&g_stream);
+    return EXIT_SUCCESS;
 }
 
 //-----------------------------------------------------------------------------
@@ -537,11 +999,40 @@ void stop_portAudio(PaStream **g_stream) {
 //-----------------------------------------------------------------------------
 int main( int argc, char *argv[] )
 {
+    //Read the command line options
+    parse_args(argc, argv);
+
+    //Callback statistics start empty
+    lm_init(&g_meter);
+
     //Initialize datatype
     init_datastruct();
 
+    //Allocate the voices before the audio thread starts
+    init_engine();
+
+    //Headless render to a file, no window and no audio device
+    if(g_render_path != NULL){
+        int status = render_offline();
+        re_destroy(g_engine);
+        return status;
+    }
+
+    //Allocate the ring the callback publishes its output blocks into
+    g_ring = br_new(RING_SLOTS, g_buffer_size);
+
+    //Play without a window, nothing is drawn
+    if(g_headless){
+        return run_headless();
+    }
+
     /* Init waterfall */
-    memset(g_waterfall, MIN_VOLUME, WATERFALL_SIZE * g_buffer_size * sizeof(float) );
+    init_waterfall();
+
+    //Twiddles and scratch buffers for the analyser are allocated once here
+    g_fft = fft_new(g_buffer_size);
+    if (g_fft == NULL)
+        exit(1);
     
     // Initialize Glut
     initialize_glut(argc, argv);
@@ -551,6 +1042,10 @@ int main( int argc, char *argv[] )
 
     //make the transform window
     hanning(g_window, g_buffer_size);
+    g_window_gain = 0.f;
+    for (int i = 0; i < g_buffer_size; i++)
+        g_window_gain += g_window[i];
+    g_window_gain /= g_buffer_size;
 
     // Print help
     help();
@@ -573,6 +1068,35 @@ void idleFunc( )
     glutPostRedisplay( );
 }
 
+//-----------------------------------------------------------------------------
+// Name: schedule_frame( )
+// Desc: Arms a GLUT timer for the next frame at the --fps rate. Deadlines
+//       advance by whole periods, a late frame resyncs instead of bursting.
+//-----------------------------------------------------------------------------
+void schedule_frame( )
+{
+    double period = 1.0 / g_frame_rate;
+    double now = now_seconds();
+    int delay;
+
+    g_next_frame += period;
+    if( g_next_frame < now )
+        g_next_frame = now;
+
+    delay = (int)((g_next_frame - now) * 1000.0);
+    glutTimerFunc( delay, frameTimer, 0 );
+}
+
+//-----------------------------------------------------------------------------
+// Name: frameTimer( )
+// Desc: timer callback from GLUT, requests the next frame
+//-----------------------------------------------------------------------------
+void frameTimer( int value )
+{
+    glutPostRedisplay( );
+    schedule_frame( );
+}
+
 //-----------------------------------------------------------------------------
 // Name: keyboardFunc( )
 // Desc: key event
@@ -611,44 +1135,97 @@ void keyboardFunc( unsigned char key, int x, int y )
 
         case 'm':
             //if the output is muted, turn back on
-            if(data.amplitude == 0){
-                data.amplitude = 1;
+            if(data.params.amplitude == 0){
+                data.params.amplitude = 1;
             }
             else{
                 //mutes output
-                data.amplitude = 0;
+                data.params.amplitude = 0;
             }
+            publish_params();
             break;
 
         case 'w':
             //change waveform type depending on previous waveform
-            if(data.wavetype == 0){
-                data.wavetype = 1;
+            if(data.params.wavetype == 0){
+                data.params.wavetype = 1;
             }
-            else if(data.wavetype == 1){
-                data.wavetype = 2;
+            else if(data.params.wavetype == 1){
+                data.params.wavetype = 2;
             }
-            else if(data.wavetype == 2){
-                data.wavetype = 3;
+            else if(data.params.wavetype == 2){
+                data.params.wavetype = 3;
             }            
             else{
-                data.wavetype = 0;
+                data.params.wavetype = 0;
             }
+            publish_params();
+            break;
+
+        case 'n':
+            //cycle through the sine implementations
+            data.params.sine_mode = (data.params.sine_mode + 1) % SINE_MODE_COUNT;
+            printf("[RISER GENERATOR]: sine: %s\n", osc_sine_mode_name(data.params.sine_mode));
+            publish_params();
+            break;
+
+        case 'b':
+            //cycle through the filter topologies
+            data.params.topology = (data.params.topology + 1) % BQ_TOPOLOGY_COUNT;
+            printf("[RISER GENERATOR]: filters: %s\n", bq_topology_name(data.params.topology));
+            publish_params();
+            break;
+
+        case 'g':
+            //cycle through the filter shapes
+            data.params.shape = (data.params.shape + 1) % re_shape_count;
+            printf("[RISER GENERATOR]: shape: %s\n", re_shapes[data.params.shape].name);
+            publish_params();
+            break;
+
+        case 'v':
+            //cycle through the voice stacks
+            data.params.stack = (data.params.stack + 1) % re_stack_count;
+            printf("[RISER GENERATOR]: voices: %s\n", re_stacks[data.params.stack].name);
+            publish_params();
+            break;
+
+        case 'i':
+            //turn the DSP load overlay on and off
+            g_show_stats = !g_show_stats;
+            break;
+
+        case 't':
+            //switch between the line waterfall and the spectrogram
+            g_spectrogram = !g_spectrogram;
+            printf("[RISER GENERATOR]: waterfall: %s\n", g_spectrogram ? "SPECTROGRAM" : "LINES");
             break;
 
         case 's':
             //set the circle back to the begining coordinates
             g_circle.center.x = X_MIN;
             g_circle.center.y = Y_MIN;
+            //a running rise starts over from there
+            if(self_rise){
+                g_circle.coord = g_circle.center;
+                start_rise(g_rise_seconds);
+            }
+            break;
+
+        case 'c':
+            //cycle through the rise curves, used from the next rise on
+            g_rise_curve = (g_rise_curve + 1) % AU_CURVE_COUNT;
+            printf("[RISER GENERATOR]: rise curve: %s\n", au_curve_name(g_rise_curve));
             break;
 
         case ' ':
             //turn on and off the automated rise
-            self_rise = !self_rise;
-            if(self_rise){
+            if(!self_rise){
+                start_rise(g_rise_seconds);
                 printf("SELF RISING ON\n");
             }
-            if(!self_rise){
+            else{
+                stop_rise();
                 printf("SELF RISING OFF\n");
             }
             break;
@@ -780,6 +1357,17 @@ void initialize_graphics()
     glLightfv( GL_LIGHT1, GL_DIFFUSE, g_light1_diffuse );
     glLightfv( GL_LIGHT1, GL_SPECULAR, g_light1_specular );
     glEnable( GL_LIGHT1 );
+
+    // vertex buffers and shaders for everything drawn per frame
+    g_gfx_trace = gfx_trace_new(g_buffer_size);
+    g_gfx_circle = gfx_circle_new(CIRCLE_POINTS);
+    g_gfx_waterfall = gfx_waterfall_new(g_waterfall_depth, g_waterfall_width, MIN_VOLUME);
+    g_gfx_spectrogram = gfx_spectrogram_new(g_waterfall_depth, g_waterfall_width, MIN_VOLUME);
+    if (g_gfx_trace == NULL || g_gfx_circle == NULL || g_gfx_waterfall == NULL
+            || g_gfx_spectrogram == NULL) {
+        printf("[RISER GENERATOR]: could not set up the OpenGL buffers and shaders\n");
+        exit(1);
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -793,7 +1381,7 @@ void rotateView () {
     
     if (g_key_rotate_y) {
         //automatically move the object, speed depending on circle y position
-        glRotatef ( angle_y += (g_circle.center.y / 10) , 0.0f, 1.0f, 0.0f );
+        glRotatef ( angle_y += g_circle.center.y * ROTATION_RATE * g_frame_dt, 0.0f, 1.0f, 0.0f );
     }
     else {
         glRotatef (angle_y, 0.0f, 1.0f, 0.0f );
@@ -801,7 +1389,7 @@ void rotateView () {
 
     if (g_key_rotate_x) {
         //automattically move the object, speed depending on the circle x position
-        glRotatef ( angle_x += (g_circle.center.x / 10), 1.0f, 0.0f, 0.0f );
+        glRotatef ( angle_x += g_circle.center.x * ROTATION_RATE * g_frame_dt, 1.0f, 0.0f, 0.0f );
     }
     else {
         glRotatef (angle_x, 1.0f, 0.0f, 0.0f );
@@ -810,17 +1398,62 @@ void rotateView () {
 
 //-----------------------------------------------------------------------------
 // Name: void riser ()
-// automatic riser
+// automatic riser, moves the circle to the pitch and cutoff the audio
+// thread last rendered
 //-----------------------------------------------------------------------------
 void riser (){
-    if(self_rise){
-        //increase x by increase rate
-        g_circle.center.x += (RISE_INCR);
-
-        //increase y by increase rate / 2 so that circle moves diagonally
-        g_circle.center.y += (RISE_INCR/2);
+    if(self_rise && re_shown_serial(g_engine) == data.params.automation.serial){
+        params_to_position(re_shown_pitch(g_engine),
+                re_shown_cutoff(g_engine), &g_circle.center);
+        g_tex_incr.x = 0.;
+        g_tex_incr.y = 0.;
     }
 }
+
+//-----------------------------------------------------------------------------
+// Name: fill_rise()
+// Desc: describes a rise from pad position x, y to the top right corner
+//       taking seconds, with the curve picked by --curve or 'c'
+//-----------------------------------------------------------------------------
+void fill_rise(riser_automation *rise, double x, double y, double seconds)
+{
+    riser_params from, to;
+
+    position_to_params(x, y, &from);
+    position_to_params(X_MAX, Y_MAX, &to);
+
+    rise->serial++;
+    rise->running = 1;
+    rise->curve = g_rise_curve;
+    rise->seconds = seconds;
+    rise->pitch_start = from.frequency;
+    rise->pitch_end = to.frequency;
+    rise->cutoff_start = from.lowpass_freq;
+    rise->cutoff_end = to.lowpass_freq;
+}
+
+//-----------------------------------------------------------------------------
+// Name: start_rise()
+// Desc: asks the audio thread to rise from where the circle is now
+//-----------------------------------------------------------------------------
+void start_rise(double seconds)
+{
+    fill_rise(&data.params.automation, g_circle.coord.x, g_circle.coord.y, seconds);
+    self_rise = true;
+    publish_params();
+}
+
+//-----------------------------------------------------------------------------
+// Name: stop_rise()
+// Desc: stops the rise, the circle stays where it got to and takes over
+//-----------------------------------------------------------------------------
+void stop_rise()
+{
+    riser();
+    data.params.automation.running = 0;
+    self_rise = false;
+    publish_params();
+}
 //-----------------------------------------------------------------------------
 // Name: void drawWindowedTimeDomain(SAMPLE *buffer)
 // Desc: Draws the Windowed Time Domain signal in the top of the screen
@@ -845,28 +1478,73 @@ void drawWindowedTimeDomain( float z, SAMPLE *buffer) {
         //color the waveform green with blue tint
         glColor3f(0.0, 1.0, .2);
         
-        glBegin(GL_LINE_STRIP);
+        // Draw Windowed Time Domain, one upload and one draw call
+        gfx_trace_draw(g_gfx_trace, buffer, x, xinc, 4.0f);
 
-        // Draw Windowed Time Domain
-        for (int i=0; i<g_buffer_size; i++)
-        {
-            glVertex3f(x, 4*buffer[i], 0.0f);
-            x += xinc;
-        }
+    }
+    glPopMatrix();
+}
 
-        glEnd();
+//-----------------------------------------------------------------------------
+// Name: position_to_params()
+// Desc: maps a position on the pad to pitch and filter frequencies, equal
+//       distances are equal intervals
+//-----------------------------------------------------------------------------
+void position_to_params(double x, double y, riser_params *params)
+{
+    //putting the circles x location range into the filter frequency ranges
+    params->lowpass_freq = pm_to_frequency(&g_cutoff_map, (x - X_MIN) / (X_MAX - X_MIN));
+    params->highpass_freq = params->lowpass_freq - INIT_FREQUENCY;
+
+    //putting the circles y location range into the pitch frequency range
+    params->frequency = pm_to_frequency(&g_pitch_map, (y - Y_MIN) / (Y_MAX - Y_MIN));
+}
+
+//-----------------------------------------------------------------------------
+// Name: update_circle()
+// Desc: places the circle inside the pad and publishes its pitch and
+//       filter frequencies
+//-----------------------------------------------------------------------------
+void update_circle()
+{
+    //calculate the position of the circle x position
+    g_circle.coord.x = g_circle.center.x + g_tex_incr.x;
 
+    //limit the circles x position so it doesnt go off screen
+    if(g_circle.coord.x <= X_MIN){
+        g_circle.coord.x = X_MIN;
     }
-    glPopMatrix();
+    if(g_circle.coord.x >= X_MAX){
+        g_circle.coord.x = X_MAX;
+    }
+    
+    //calculate the poisition of the circle y position
+    g_circle.coord.y = g_circle.center.y + g_tex_incr.y;
+
+    //limit the circles y position so that it doesnt go off screen
+    if(g_circle.coord.y <= Y_MIN){
+        g_circle.coord.y = Y_MIN;
+    }
+    if(g_circle.coord.y >= Y_MAX){
+        g_circle.coord.y = Y_MAX;
+    }
+    
+    //turn the circles position into pitch and filter frequencies
+    position_to_params(g_circle.coord.x, g_circle.coord.y, &data.params);
+
+    //hand the new pitch and cutoffs to the audio thread
+    publish_params();
 }
 
 //-----------------------------------------------------------------------------
-// Name: round()
-// Desc: rouds up number using math function
+// Name: params_to_position()
+// Desc: inverse of position_to_params, the pad position of a pitch and
+//       lowpass frequency
 //-----------------------------------------------------------------------------
-double round(double d)
+void params_to_position(double frequency, double lowpass_freq, Pos *pos)
 {
-    return floor(d + 0.5);
+    pos->x = X_MIN + pm_to_position(&g_cutoff_map, lowpass_freq) * (X_MAX - X_MIN);
+    pos->y = Y_MIN + pm_to_position(&g_pitch_map, frequency) * (Y_MAX - Y_MIN);
 }
 
 //-----------------------------------------------------------------------------
@@ -877,40 +1555,11 @@ void drawCircle()
 {
     glPushMatrix();
     {
-        //automate the circle with spacebar
+        //follow the rise started with spacebar
         riser ();
 
-        //calculate the position of the circle x position
-        g_circle.coord.x = g_circle.center.x + g_tex_incr.x;
+        update_circle();
 
-        //limit the circles x position so it doesnt go off screen
-        if(g_circle.coord.x <= X_MIN){
-            g_circle.coord.x = X_MIN;
-        }
-        if(g_circle.coord.x >= X_MAX){
-            g_circle.coord.x = X_MAX;
-        }
-        
-        //putting the circles x location range into the filter frequency ranges
-        double filter_slope = 1.0 * (INIT_FREQUENCY*8.0) / (X_MAX*2);
-        data.lowpass_freq = round(filter_slope * (g_circle.coord.x+X_MAX));
-        data.highpass_freq = round(filter_slope * (g_circle.coord.x+X_MAX)) - INIT_FREQUENCY;
-        
-        //calculate the poisition of the circle y position
-        g_circle.coord.y = g_circle.center.y + g_tex_incr.y;
-
-        //limit the circles y position so that it doesnt go off screen
-        if(g_circle.coord.y <= Y_MIN){
-            g_circle.coord.y = Y_MIN;
-        }
-        if(g_circle.coord.y >= Y_MAX){
-            g_circle.coord.y = Y_MAX;
-        }
-        
-        //putting the circles y location range into the pitch frequency range
-        double pitch_slope = 1.0 * ((INIT_FREQUENCY*8.0) - INIT_FREQUENCY) / (Y_MAX*2);
-        data.frequency = INIT_FREQUENCY + round(pitch_slope * (g_circle.coord.y + Y_MAX));
-        
         //sets the coordinates for the circle
         glTranslatef(g_circle.coord.x,g_circle.coord.y, 0.0f);
 
@@ -920,59 +1569,161 @@ void drawCircle()
         //color the circle red
         glColor3f(1.0, 0.0, 0.0);
         
-        //Draw the actual circle
-        glBegin(GL_LINE_LOOP);
-
-        for(int i =0; i <= 300; i++){
-            double angle = 2 * PI * i / 300;
-            double x = cos(angle);
-            double y = sin(angle);
-            glVertex2d(x,y);
-        }
-
-        glEnd();
+        //Draw the actual circle, the outline was built once at startup
+        gfx_circle_draw(g_gfx_circle);
     }
     glPopMatrix();
 }
+//-----------------------------------------------------------------------------
+// Name: init_waterfall()
+// Desc: Allocates the waterfall history, rows below MIN_VOLUME are not drawn
+//-----------------------------------------------------------------------------
+void init_waterfall() {
+    int i;
+    g_waterfall = (float*)malloc(g_waterfall_depth * g_waterfall_width * sizeof(float));
+    if (g_waterfall == NULL) {
+        printf("Error while allocating memory for the waterfall");
+        exit(1);
+    }
+    for (i = 0; i < g_waterfall_depth * g_waterfall_width; i++)
+        g_waterfall[i] = MIN_VOLUME;
+    for (i = 0; i < g_buffer_size / 2; i++)
+        g_spectrum[i] = MIN_VOLUME;
+    g_waterfall_head = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name: push_waterfall()
+// Desc: Makes spectrum the newest waterfall row. The oldest row is
+//       overwritten in place, each column keeps the loudest of its bins.
+//-----------------------------------------------------------------------------
+void push_waterfall(const float *spectrum, int bins) {
+    int column, i;
+
+    g_waterfall_head = (g_waterfall_head + g_waterfall_depth - 1) % g_waterfall_depth;
+    float *row = g_waterfall + g_waterfall_head * g_waterfall_width;
+
+    for (column = 0; column < g_waterfall_width; column++) {
+        int first = column * bins / g_waterfall_width;
+        int last = (column + 1) * bins / g_waterfall_width;
+        float level = spectrum[first];
+        for (i = first + 1; i < last; i++) {
+            if (spectrum[i] > level)
+                level = spectrum[i];
+        }
+        row[column] = level;
+    }
+
+    //overwrite the same row of both GPU copies, so either look can be drawn
+    gfx_waterfall_push(g_gfx_waterfall, g_waterfall_head, row);
+    gfx_spectrogram_push(g_gfx_spectrogram, g_waterfall_head, row);
+}
+
 //-----------------------------------------------------------------------------
 // Name: drawSpectrum() copied from lab 11
-// Desc: Draws the frequency spectrum cascading
+// Desc: Draws the frequency spectrum cascading, newest row in front, as
+//       lines or as a spectrogram (g_spectrogram)
 //-----------------------------------------------------------------------------
-void drawSpectrum(float *buffer, int length) {
+void drawSpectrum(int length) {
+    GLfloat zinc = (GLfloat)WATERFALL_SPAN / g_waterfall_depth;
+
+    // Initialize initial x
+    GLfloat x = -(length-length*0.2)/2.0f;
+
+    // Calculate increment x
+    GLfloat xinc = fabs((2*x)/(float)g_waterfall_width);
+
     // Deactivate the texture
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    // Draw Time Domain
-    int i, k;
-    for (k = WATERFALL_SIZE - 1; k >= 0; k--) {
-        // Initialize initial x
-        GLfloat x = -(length-length*0.2)/2.0f;
+    // a single colormapped quad, history depth only costs texture memory
+    if (g_spectrogram) {
+        gfx_spectrogram_draw(g_gfx_spectrogram, g_waterfall_head, x,
+                xinc * g_waterfall_width, zinc * g_waterfall_depth, 0.0f,
+                SPECTRUM_FLOOR, SPECTRUM_RANGE, MIN_VOLUME);
+        return;
+    }
 
-        // Calculate increment x
-        GLfloat xinc = fabs((2*x)/(float)g_buffer_size);
-        
-        glColor4f(0.4, .2, 1.0, 1 - (float)k / (float)WATERFALL_SIZE);
+    // the whole history in one draw call, the vertex shader places each
+    // row by its distance from the head and fades it with age
+    gfx_waterfall_draw(g_gfx_waterfall, g_waterfall_head, x, xinc, zinc,
+            SPECTRUM_FLOOR, SPECTRUM_SCALE, MIN_VOLUME, 0.4f, .2f, 1.0f);
+}
+//-----------------------------------------------------------------------------
+// Name: update_stats()
+// Desc: Refreshes the overlay figures every OVERLAY_REFRESH seconds and
+//       prints a load report every --stats seconds, none with 0. Each
+//       keeps its own snapshot, so both cover their whole interval.
+//-----------------------------------------------------------------------------
+void update_stats(double now) {
+    static load_snapshot overlay_snapshot, console_snapshot, current;
+    static double overlay_time = 0., console_time = 0.;
+    load_report report;
+
+    if (overlay_time == 0.) {
+        lm_snapshot(&g_meter, &overlay_snapshot);
+        console_snapshot = overlay_snapshot;
+        overlay_time = console_time = now;
+        return;
+    }
 
-        glBegin(GL_LINE_STRIP);
-        for (i = 0; i < g_buffer_size; i++)
-        {
-            if (g_waterfall[k][i] > MIN_VOLUME) {
-                glVertex3f(x, g_waterfall[k][i], -k*100);
-            }
-            x += xinc;
-            
-        }
-        glEnd();
+    if (now - overlay_time >= OVERLAY_REFRESH) {
+        lm_snapshot(&g_meter, &current);
+        lm_report(&overlay_snapshot, &current, &g_overlay_report);
+        overlay_snapshot = current;
+        overlay_time = now;
+    }
 
-        if (k == 0) {
-            memcpy( g_waterfall[k], buffer, g_buffer_size * sizeof(float) );
-        }
-        else {
-            memcpy( g_waterfall[k], g_waterfall[k - 1], g_buffer_size * sizeof(float) );
-        }
+    if (g_stats_interval > 0 && now - console_time >= g_stats_interval) {
+        lm_snapshot(&g_meter, &current);
+        lm_report(&console_snapshot, &current, &report);
+        lm_print(&report);
+        console_snapshot = current;
+        console_time = now;
     }
+}
+
+//-----------------------------------------------------------------------------
+// Name: drawStats()
+// Desc: Writes the last load figures into the top left corner
+//-----------------------------------------------------------------------------
+void drawStats() {
+    char line[128];
+    const load_report *r = &g_overlay_report;
+    char *c;
+
+    snprintf(line, sizeof(line),
+            "DSP %d frames  avg %.1f%%  p99 %.1f%%  max %.1f%%  underflows %u",
+            r->block_size, r->avg * 100., r->p99 * 100., r->max * 100., r->underflows);
 
+    // window coordinates, no depth test or lighting for the text
+    glMatrixMode( GL_PROJECTION );
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho( 0, g_width, 0, g_height, -1, 1 );
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glLoadIdentity();
+    glPushAttrib( GL_ENABLE_BIT | GL_CURRENT_BIT );
+    glDisable( GL_DEPTH_TEST );
+    glDisable( GL_LIGHTING );
+
+    // red once the worst block got close to the deadline
+    if (r->underflows > 0 || r->max > .8)
+        glColor3f( 1.0f, 0.3f, 0.3f );
+    else
+        glColor3f( 0.8f, 0.8f, 0.8f );
+    glRasterPos2i( 10, g_height - 20 );
+    for (c = line; *c != '\0'; c++)
+        glutBitmapCharacter( GLUT_BITMAP_HELVETICA_12, *c );
+
+    glPopAttrib();
+    glPopMatrix();
+    glMatrixMode( GL_PROJECTION );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
 }
+
 //-----------------------------------------------------------------------------
 // Name: displayFunc( )
 // Desc: callback function invoked to draw the client area
@@ -981,12 +1732,25 @@ void displayFunc( )
 {
     // local variables
     SAMPLE buffer[g_buffer_size];
-
-    // wait for data
-    while( !g_ready ) usleep( 1000 );
-
-    // Hand off to audio callback thread
-    g_ready = false;
+    double now = now_seconds();
+
+    // wall clock time since the last frame drives the animation, a stall
+    // (window drag, breakpoint) does not make the circle jump
+    g_frame_dt = g_last_frame > 0. ? now - g_last_frame : 0.;
+    if (g_frame_dt > MAX_FRAME_DT)
+        g_frame_dt = MAX_FRAME_DT;
+    g_last_frame = now;
+
+    // take the newest output block, keep drawing the last one if the
+    // audio thread has not published a new one yet
+    if (br_read_latest(g_ring, g_buffer)) {
+        // window a copy of the block and turn it into dB magnitudes,
+        // off the audio thread so the callback never pays for it
+        memcpy(buffer, g_buffer, g_buffer_size * sizeof(SAMPLE));
+        apply_window( (float*)buffer, g_window, g_buffer_size );
+        fft_magnitude_db(g_fft, buffer, g_spectrum, g_window_gain, SPECTRUM_FLOOR);
+        push_waterfall(g_spectrum, g_buffer_size / 2);
+    }
 
     // clear the color and depth buffers
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
@@ -999,10 +1763,12 @@ void displayFunc( )
     drawCircle();
     
     // Draw spectrum
-    drawSpectrum(g_buffer, 500);
+    drawSpectrum(500);
 
-    // apply the transform window
-    apply_window( (float*)buffer, g_window, g_buffer_size );
+    // DSP load, on top of everything
+    update_stats(now);
+    if (g_show_stats)
+        drawStats();
 
     // flush gl commands
     glFlush( );